@@ -1,6 +1,21 @@
 #!/bin/sh
 
+# Usage: ./build.sh [release | font]
+# release builds with EVERYDAY_SLOW=0 and EVERYDAY_INTERNAL=0 at -O2; see pgo.sh
+# for the -march=native, LTO and PGO configurations.
+# font regenerates the checked-in everyday_font.h from everyday_font.txt and
+# builds nothing else; commit the result along with the glyphs.
+
 mkdir -p ../build
 pushd ../build
+if [ "$1" = "font" ]; then
+cc ../code/everyday_font_baker.cpp -g -o everyday_font_baker
+./everyday_font_baker ../code/everyday_font.txt ../code/everyday_font.h
+elif [ "$1" = "release" ]; then
+cc -DEVERYDAY_INTERNAL=0 -DEVERYDAY_SLOW=0 ../code/sdl_everyday.cpp -O2 $(pkg-config --libs --cflags sdl3) -o everyday_release
+cc -DEVERYDAY_INTERNAL=0 -DEVERYDAY_SLOW=0 ../code/headless_everyday.cpp -O2 -lm -o everyday_headless_release
+else
 cc -DEVERYDAY_INTERNAL=1 -DEVERYDAY_SLOW=1 ../code/sdl_everyday.cpp -g $(pkg-config --libs --cflags sdl3) -o everyday
+cc -DEVERYDAY_INTERNAL=1 -DEVERYDAY_SLOW=1 ../code/headless_everyday.cpp -g -lm -o everyday_headless
+fi
 popd
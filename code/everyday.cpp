@@ -18,34 +18,101 @@ static void RenderGradient(game_offscreen_buffer *Buffer, int BlueOffset, int Gr
     }
 }
 
-static void GameOutputSound(game_sound_output_buffer *SoundBuffer, int ToneHz)
+static bool32 PushSoundCommand(game_sound_command_queue *Queue, game_sound_command *Command)
 {
-    static float tSine;
-    int16_t ToneVolume = 3000;
-    int WavePeriod = SoundBuffer->SamplesPerSecond/ToneHz;
+    uint32_t WriteIndex = Queue->WriteIndex;
+    uint32_t ReadIndex = AtomicLoadAcquire(&Queue->ReadIndex);
+    if (WriteIndex - ReadIndex >= SOUND_COMMAND_QUEUE_SIZE)
+    {
+        // NOTE: Queue is full, the mixer has fallen behind. Drop the command.
+        return false;
+    }
+
+    Queue->Commands[WriteIndex & (SOUND_COMMAND_QUEUE_SIZE - 1)] = *Command;
+    AtomicStoreRelease(&Queue->WriteIndex, WriteIndex + 1);
+    return true;
+}
+
+static bool32 PopSoundCommand(game_sound_command_queue *Queue, game_sound_command *Command)
+{
+    uint32_t ReadIndex = Queue->ReadIndex;
+    uint32_t WriteIndex = AtomicLoadAcquire(&Queue->WriteIndex);
+    if (ReadIndex == WriteIndex)
+    {
+        return false;
+    }
+
+    *Command = Queue->Commands[ReadIndex & (SOUND_COMMAND_QUEUE_SIZE - 1)];
+    AtomicStoreRelease(&Queue->ReadIndex, ReadIndex + 1);
+    return true;
+}
 
+static void GameOutputSound(game_sound_mixer *Mixer, game_sound_output_buffer *SoundBuffer)
+{
+    int16_t ToneVolume = 3000;
     int16_t *SampleOut = SoundBuffer->Samples;
+
+    if (Mixer->ToneHz <= 0)
+    {
+        // NOTE: No tone yet, the game hasn't run its first frame.
+        for(int SampleIndex = 0;
+            SampleIndex < SoundBuffer->SampleCount;
+            ++SampleIndex)
+        {
+            *SampleOut++ = 0;
+            *SampleOut++ = 0;
+        }
+        return;
+    }
+
+    int WavePeriod = SoundBuffer->SamplesPerSecond/Mixer->ToneHz;
     for(int SampleIndex = 0;
         SampleIndex < SoundBuffer->SampleCount;
         ++SampleIndex)
     {
         // TODO(casey): Draw this out for people
-        float SineValue = sinf(tSine);
+        float SineValue = sinf(Mixer->tSine);
         int16_t SampleValue = (int16_t)(SineValue * ToneVolume);
         *SampleOut++ = SampleValue;
         *SampleOut++ = SampleValue;
 
-        tSine += 2.0f*Pi32*1.0f/(float)WavePeriod;
+        Mixer->tSine += 2.0f*Pi32*1.0f/(float)WavePeriod;
+        // NOTE: The mixer runs for the life of the program, keep the phase small so sinf stays precise.
+        if (Mixer->tSine > 2.0f*Pi32)
+        {
+            Mixer->tSine -= 2.0f*Pi32;
+        }
+    }
+}
+
+static void GameGetSoundSamples(game_memory *Memory, game_sound_output_buffer *SoundBuffer)
+{
+    Assert(sizeof(game_sound_mixer) <= Memory->TransientStorageSize);
+
+    game_sound_mixer *Mixer = (game_sound_mixer *)Memory->TransientStorage;
+
+    game_sound_command Command;
+    while (PopSoundCommand(&Mixer->Commands, &Command))
+    {
+        switch (Command.Type)
+        {
+            case SoundCommand_SetTone:
+            {
+                Mixer->ToneHz = Command.ToneHz;
+            } break;
+        }
     }
+
+    GameOutputSound(Mixer, SoundBuffer);
 }
 
-static void GameUpdateAndRender(game_memory *Memory, game_input *Input, game_offscreen_buffer *Buffer,
-                                game_sound_output_buffer *SoundBuffer) {
+static void GameUpdateAndRender(game_memory *Memory, game_input *Input, game_offscreen_buffer *Buffer) {
 
     Assert(sizeof(game_state) <= Memory->PersistentStorageSize);
 
     game_state *GameState = (game_state *)Memory->PersistentStorage;
     if(!Memory->IsInitialized) {
+#if EVERYDAY_INTERNAL
         char *Filename = __FILE__;
         
         debug_read_file_result File = DEBUGPlatformReadEntireFile(Filename);
@@ -54,6 +121,7 @@ static void GameUpdateAndRender(game_memory *Memory, game_input *Input, game_off
             DEBUGPlatformWriteEntireFile("test.out", File.ContentsSize, File.Contents);
             DEBUGPlatformFreeFileMemory(File.Contents);
         }
+#endif
         GameState->ToneHz = 256;
 
         Memory->IsInitialized = true;
@@ -78,5 +146,11 @@ static void GameUpdateAndRender(game_memory *Memory, game_input *Input, game_off
         GameState->GreenOffset += 1;
     }
     RenderGradient(Buffer, GameState->BlueOffset, GameState->GreenOffset);
-    GameOutputSound(SoundBuffer, GameState->ToneHz);
+
+    // NOTE: Sent every frame rather than on change, so the mixer also follows a quick-load.
+    game_sound_mixer *Mixer = (game_sound_mixer *)Memory->TransientStorage;
+    game_sound_command Command = {};
+    Command.Type = SoundCommand_SetTone;
+    Command.ToneHz = GameState->ToneHz;
+    PushSoundCommand(&Mixer->Commands, &Command);
 }
@@ -17,6 +17,18 @@
 
 typedef int32_t bool32;
 
+// NOTE: Single-word acquire/release accesses for data shared between the game
+// thread and the audio thread.
+inline uint32_t AtomicLoadAcquire(volatile uint32_t *Value)
+{
+    return(__atomic_load_n(Value, __ATOMIC_ACQUIRE));
+}
+
+inline void AtomicStoreRelease(volatile uint32_t *Value, uint32_t NewValue)
+{
+    __atomic_store_n(Value, NewValue, __ATOMIC_RELEASE);
+}
+
 inline uint32_t SafeTruncateUInt64(uint64_t Value)
 {
     Assert(Value <= 0xFFFFFFFF);
@@ -41,6 +53,38 @@ struct game_state {
     int ToneHz;
 };
 
+enum game_sound_command_type
+{
+    SoundCommand_SetTone,
+};
+
+struct game_sound_command
+{
+    game_sound_command_type Type;
+    int ToneHz;
+};
+
+#define SOUND_COMMAND_QUEUE_SIZE 256
+
+// NOTE: Lock-free, single producer (GameUpdateAndRender) and single consumer
+// (GameGetSoundSamples). Indices only ever increase; SOUND_COMMAND_QUEUE_SIZE
+// must be a power of two.
+struct game_sound_command_queue
+{
+    volatile uint32_t WriteIndex;
+    volatile uint32_t ReadIndex;
+    game_sound_command Commands[SOUND_COMMAND_QUEUE_SIZE];
+};
+
+// NOTE: Owned by whichever thread calls GameGetSoundSamples. Lives at the start of
+// TransientStorage so it is never part of a save state or the state hash.
+struct game_sound_mixer
+{
+    game_sound_command_queue Commands;
+    int ToneHz;
+    float tSine;
+};
+
 struct game_memory {
     bool32 IsInitialized;
     uint64_t PersistentStorageSize;
@@ -106,8 +150,11 @@ struct game_input
 };
 
 
-static void GameUpdateAndRender(game_memory *GameMemory, game_input *Input, game_offscreen_buffer *Buffer,
-                                game_sound_output_buffer *SoundBuffer);
+static void GameUpdateAndRender(game_memory *GameMemory, game_input *Input, game_offscreen_buffer *Buffer);
+
+// NOTE: May be called from a different thread than GameUpdateAndRender, on its own
+// schedule and with any SampleCount.
+static void GameGetSoundSamples(game_memory *GameMemory, game_sound_output_buffer *SoundBuffer);
 
 #define EVERYDAY_H
 #endif // !EVERYDAY_H
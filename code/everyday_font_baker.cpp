@@ -0,0 +1,175 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// NOTE: Build-time tool. Turns the hand-drawn glyphs in everyday_font.txt into
+// everyday_font.h, one byte per glyph row, so the game never parses a font at runtime.
+//
+// Usage: everyday_font_baker everyday_font.txt everyday_font.h
+
+#define FONT_GLYPH_WIDTH 5
+#define FONT_GLYPH_HEIGHT 7
+#define FONT_FIRST_CHAR ' '
+#define FONT_LAST_CHAR '_'
+#define FONT_GLYPH_COUNT (FONT_LAST_CHAR - FONT_FIRST_CHAR + 1)
+
+struct baked_font
+{
+    bool Defined[FONT_GLYPH_COUNT];
+    uint8_t Rows[FONT_GLYPH_COUNT][FONT_GLYPH_HEIGHT];
+};
+
+static int StripLineEnd(char *Line)
+{
+    int Length = (int)strlen(Line);
+    while (Length > 0 && (Line[Length - 1] == '\n' || Line[Length - 1] == '\r'))
+    {
+        Line[--Length] = 0;
+    }
+    return(Length);
+}
+
+static bool ParseFont(FILE *File, char *Filename, baked_font *Font)
+{
+    char Line[256];
+    int LineNumber = 0;
+    int Glyph = -1;
+    int Row = 0;
+
+    while (fgets(Line, sizeof(Line), File))
+    {
+        ++LineNumber;
+        int Length = StripLineEnd(Line);
+
+        if (Glyph < 0)
+        {
+            // NOTE: Between glyphs: blank lines and "# " comments, or a single character starting a glyph.
+            if (Length == 0 || (Length > 1 && Line[0] == '#'))
+            {
+                continue;
+            }
+
+            if (Length != 1 || Line[0] < FONT_FIRST_CHAR || Line[0] > FONT_LAST_CHAR)
+            {
+                fprintf(stderr, "%s:%d: expected a glyph character between '%c' and '%c'\n",
+                        Filename, LineNumber, FONT_FIRST_CHAR, FONT_LAST_CHAR);
+                return false;
+            }
+
+            Glyph = Line[0] - FONT_FIRST_CHAR;
+            if (Font->Defined[Glyph])
+            {
+                fprintf(stderr, "%s:%d: glyph '%c' defined twice\n", Filename, LineNumber, Line[0]);
+                return false;
+            }
+            Font->Defined[Glyph] = true;
+            Row = 0;
+        }
+        else
+        {
+            if (Length != FONT_GLYPH_WIDTH)
+            {
+                fprintf(stderr, "%s:%d: glyph rows must be %d pixels wide\n", Filename, LineNumber, FONT_GLYPH_WIDTH);
+                return false;
+            }
+
+            uint8_t Bits = 0;
+            for (int X = 0; X < FONT_GLYPH_WIDTH; ++X)
+            {
+                if (Line[X] != '#' && Line[X] != '.')
+                {
+                    fprintf(stderr, "%s:%d: glyph pixels must be '#' or '.'\n", Filename, LineNumber);
+                    return false;
+                }
+                Bits = (uint8_t)((Bits << 1) | (Line[X] == '#'));
+            }
+            Font->Rows[Glyph][Row++] = Bits;
+
+            if (Row == FONT_GLYPH_HEIGHT)
+            {
+                Glyph = -1;
+            }
+        }
+    }
+
+    if (Glyph >= 0)
+    {
+        fprintf(stderr, "%s: glyph '%c' has only %d rows\n", Filename, Glyph + FONT_FIRST_CHAR, Row);
+        return false;
+    }
+
+    return true;
+}
+
+static bool WriteFontHeader(FILE *File, baked_font *Font)
+{
+    fprintf(File, "#ifndef EVERYDAY_FONT_H\n\n");
+    fprintf(File, "// NOTE: Generated by everyday_font_baker from everyday_font.txt. Do not edit.\n\n");
+    fprintf(File, "#define FONT_GLYPH_WIDTH %d\n", FONT_GLYPH_WIDTH);
+    fprintf(File, "#define FONT_GLYPH_HEIGHT %d\n", FONT_GLYPH_HEIGHT);
+    fprintf(File, "#define FONT_FIRST_CHAR '%c'\n", FONT_FIRST_CHAR);
+    fprintf(File, "#define FONT_LAST_CHAR '%c'\n\n", FONT_LAST_CHAR);
+    fprintf(File, "// NOTE: One byte per glyph row, leftmost pixel in bit %d.\n", FONT_GLYPH_WIDTH - 1);
+    fprintf(File, "static const uint8_t FontGlyphRows[%d][FONT_GLYPH_HEIGHT] =\n{\n", FONT_GLYPH_COUNT);
+    for (int Glyph = 0; Glyph < FONT_GLYPH_COUNT; ++Glyph)
+    {
+        fprintf(File, "    {");
+        for (int Row = 0; Row < FONT_GLYPH_HEIGHT; ++Row)
+        {
+            fprintf(File, "0x%02x%s", Font->Rows[Glyph][Row], (Row + 1 < FONT_GLYPH_HEIGHT) ? ", " : "");
+        }
+        fprintf(File, "}, // '%c'\n", Glyph + FONT_FIRST_CHAR);
+    }
+    fprintf(File, "};\n\n");
+    fprintf(File, "#define EVERYDAY_FONT_H\n#endif // !EVERYDAY_FONT_H\n");
+
+    return(ferror(File) == 0);
+}
+
+int main(int ArgCount, char **Args)
+{
+    if (ArgCount != 3)
+    {
+        fprintf(stderr, "Usage: %s everyday_font.txt everyday_font.h\n", Args[0]);
+        return 2;
+    }
+
+    FILE *Input = fopen(Args[1], "r");
+    if (!Input)
+    {
+        fprintf(stderr, "Couldn't open %s\n", Args[1]);
+        return 1;
+    }
+
+    baked_font Font = {};
+    bool Parsed = ParseFont(Input, Args[1], &Font);
+    fclose(Input);
+    if (!Parsed)
+    {
+        return 1;
+    }
+
+    for (int Glyph = 0; Glyph < FONT_GLYPH_COUNT; ++Glyph)
+    {
+        if (!Font.Defined[Glyph])
+        {
+            fprintf(stderr, "%s: warning: glyph '%c' missing, left blank\n", Args[1], Glyph + FONT_FIRST_CHAR);
+        }
+    }
+
+    FILE *Output = fopen(Args[2], "w");
+    if (!Output)
+    {
+        fprintf(stderr, "Couldn't open %s for writing\n", Args[2]);
+        return 1;
+    }
+
+    bool Written = WriteFontHeader(Output, &Font);
+    if (fclose(Output) != 0 || !Written)
+    {
+        fprintf(stderr, "Couldn't write %s\n", Args[2]);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,466 @@
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "everyday_snapshot.h"
+
+#if defined(__APPLE__)
+typedef char mincore_vector;
+#else
+typedef unsigned char mincore_vector;
+#endif
+
+#define XXH_PRIME64_1 0x9E3779B185EBCA87ULL
+#define XXH_PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define XXH_PRIME64_3 0x165667B19E3779F9ULL
+#define XXH_PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define XXH_PRIME64_5 0x27D4EB2F165667C5ULL
+
+inline uint64_t RotateLeft64(uint64_t Value, int Shift)
+{
+    return((Value << Shift) | (Value >> (64 - Shift)));
+}
+
+inline uint64_t XXH64Round(uint64_t Accumulator, uint64_t Input)
+{
+    Accumulator += Input * XXH_PRIME64_2;
+    Accumulator = RotateLeft64(Accumulator, 31);
+    Accumulator *= XXH_PRIME64_1;
+    return(Accumulator);
+}
+
+inline uint64_t XXH64MergeRound(uint64_t Accumulator, uint64_t Value)
+{
+    Accumulator ^= XXH64Round(0, Value);
+    Accumulator = Accumulator * XXH_PRIME64_1 + XXH_PRIME64_4;
+    return(Accumulator);
+}
+
+// NOTE: Plain XXH64 (little-endian reads). The state hash built on top of it in
+// SnapshotHashPage is a sum of chunk hashes, not the XXH64 of the whole block.
+static uint64_t HashBytes(void *Data, uint64_t Size, uint64_t Seed)
+{
+    uint8_t *At = (uint8_t *)Data;
+    uint8_t *End = At + Size;
+    uint64_t Hash;
+
+    if (Size >= 32)
+    {
+        uint64_t V1 = Seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+        uint64_t V2 = Seed + XXH_PRIME64_2;
+        uint64_t V3 = Seed;
+        uint64_t V4 = Seed - XXH_PRIME64_1;
+
+        uint8_t *Limit = End - 32;
+        do
+        {
+            uint64_t Lanes[4];
+            memcpy(Lanes, At, sizeof(Lanes));
+            V1 = XXH64Round(V1, Lanes[0]);
+            V2 = XXH64Round(V2, Lanes[1]);
+            V3 = XXH64Round(V3, Lanes[2]);
+            V4 = XXH64Round(V4, Lanes[3]);
+            At += 32;
+        } while (At <= Limit);
+
+        Hash = (RotateLeft64(V1, 1) + RotateLeft64(V2, 7) +
+                RotateLeft64(V3, 12) + RotateLeft64(V4, 18));
+        Hash = XXH64MergeRound(Hash, V1);
+        Hash = XXH64MergeRound(Hash, V2);
+        Hash = XXH64MergeRound(Hash, V3);
+        Hash = XXH64MergeRound(Hash, V4);
+    }
+    else
+    {
+        Hash = Seed + XXH_PRIME64_5;
+    }
+
+    Hash += Size;
+
+    while (At + 8 <= End)
+    {
+        uint64_t Lane;
+        memcpy(&Lane, At, sizeof(Lane));
+        Hash ^= XXH64Round(0, Lane);
+        Hash = RotateLeft64(Hash, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+        At += 8;
+    }
+
+    if (At + 4 <= End)
+    {
+        uint32_t Lane;
+        memcpy(&Lane, At, sizeof(Lane));
+        Hash ^= (uint64_t)Lane * XXH_PRIME64_1;
+        Hash = RotateLeft64(Hash, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+        At += 4;
+    }
+
+    while (At < End)
+    {
+        Hash ^= (*At++) * XXH_PRIME64_5;
+        Hash = RotateLeft64(Hash, 11) * XXH_PRIME64_1;
+    }
+
+    Hash ^= Hash >> 33;
+    Hash *= XXH_PRIME64_2;
+    Hash ^= Hash >> 29;
+    Hash *= XXH_PRIME64_3;
+    Hash ^= Hash >> 32;
+
+    return(Hash);
+}
+
+// NOTE: The state hash is taken over fixed 4 KiB chunks seeded with their byte offset,
+// never over whole system pages, so the same state hashes the same on 16 KiB and 64 KiB
+// page hosts.
+#define SNAPSHOT_HASH_CHUNK_SIZE 4096
+
+static bool32 IsPageZero(uint8_t *Page, uint64_t PageSize)
+{
+    uint64_t *At = (uint64_t *)Page;
+    uint64_t Combined = 0;
+    for (uint64_t Index = 0; Index < PageSize / sizeof(uint64_t); ++Index)
+    {
+        Combined |= At[Index];
+    }
+    return(Combined == 0);
+}
+
+// NOTE: Anonymous pages that were never written are not resident and read back as
+// zero, so the residency vector tells us which part of the block the game has used.
+// This assumes game memory is not swapped out.
+static uint64_t SnapshotQueryResidency(state_snapshots *Snapshots, uint8_t *Residency)
+{
+    uint64_t ResidentCount = 0;
+    if (mincore(Snapshots->Storage, Snapshots->StorageSize, (mincore_vector *)Residency) == 0)
+    {
+        for (uint64_t PageIndex = 0; PageIndex < Snapshots->PageCount; ++PageIndex)
+        {
+            Residency[PageIndex] &= 1;
+            ResidentCount += Residency[PageIndex];
+        }
+    }
+    else
+    {
+        // NOTE: Without residency information treat every page as used.
+        memset(Residency, 1, Snapshots->PageCount);
+        ResidentCount = Snapshots->PageCount;
+    }
+    return(ResidentCount);
+}
+
+#if defined(__linux__)
+#define PAGEMAP_PRESENT (1ULL << 63)
+#define PAGEMAP_SWAPPED (1ULL << 62)
+#define PAGEMAP_FILE_PAGE (1ULL << 61)
+
+static bool SnapshotReadPageMap(state_snapshots *Snapshots)
+{
+    uint64_t Size = Snapshots->PageCount * sizeof(uint64_t);
+    off_t Offset = (off_t)(((uintptr_t)Snapshots->Storage / Snapshots->PageSize) * sizeof(uint64_t));
+    return(pread(Snapshots->PageMapFile, Snapshots->PageMapEntries, Size, Offset) == (ssize_t)Size);
+}
+
+// NOTE: A page of a MAP_PRIVATE file mapping that has been written is a private
+// anonymous copy; untouched or committed pages are the file's own pages.
+inline bool32 IsWrittenPage(uint64_t PageMapEntry)
+{
+    return(((PageMapEntry & PAGEMAP_PRESENT) && !(PageMapEntry & PAGEMAP_FILE_PAGE)) ||
+           (PageMapEntry & PAGEMAP_SWAPPED));
+}
+
+// NOTE: Writes Source over the file contents of a run of pages and drops the storage's
+// private copies, so the storage reads the file again and the pages count as clean.
+static bool SnapshotCommitPages(state_snapshots *Snapshots, uint8_t *Source, uint64_t FirstPage, uint64_t PageCount)
+{
+    uint64_t Offset = FirstPage * Snapshots->PageSize;
+    uint64_t Size = PageCount * Snapshots->PageSize;
+
+    uint64_t BytesWritten = 0;
+    while (BytesWritten < Size)
+    {
+        ssize_t Written = pwrite(Snapshots->MemoryFile, Source + Offset + BytesWritten,
+                                 Size - BytesWritten, (off_t)(Offset + BytesWritten));
+        if (Written <= 0)
+        {
+            // NOTE: Keep the private copies; they will be retried on the next collect.
+            return false;
+        }
+        BytesWritten += Written;
+    }
+
+    return(madvise(Snapshots->Storage + Offset, Size, MADV_DONTNEED) == 0);
+}
+
+static bool SnapshotInitDirtyTracking(state_snapshots *Snapshots)
+{
+    Snapshots->MemoryFile = memfd_create("everyday_state", MFD_CLOEXEC);
+    if (Snapshots->MemoryFile == -1 || ftruncate(Snapshots->MemoryFile, Snapshots->StorageSize) != 0)
+    {
+        return false;
+    }
+
+    Snapshots->PageMapFile = open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+    Snapshots->PageMapEntries = (uint64_t *)mmap(0, Snapshots->PageCount * sizeof(uint64_t), PROT_READ | PROT_WRITE,
+                                                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (Snapshots->PageMapFile == -1 || Snapshots->PageMapEntries == MAP_FAILED)
+    {
+        return false;
+    }
+
+    // NOTE: The storage has not been touched yet, so swapping in an equally zeroed file mapping is invisible to the game.
+    if (mmap(Snapshots->Storage, Snapshots->StorageSize, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_FIXED, Snapshots->MemoryFile, 0) == MAP_FAILED)
+    {
+        return false;
+    }
+
+    // NOTE: Make sure the kernel reports written pages the way we expect.
+    *(volatile uint8_t *)Snapshots->Storage = 0;
+    if (!SnapshotReadPageMap(Snapshots) || !IsWrittenPage(Snapshots->PageMapEntries[0]) ||
+        !SnapshotCommitPages(Snapshots, Snapshots->Storage, 0, 1) ||
+        !SnapshotReadPageMap(Snapshots) || IsWrittenPage(Snapshots->PageMapEntries[0]))
+    {
+        mmap(Snapshots->Storage, Snapshots->StorageSize, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+        return false;
+    }
+
+    return true;
+}
+#endif
+
+// NOTE: Must be called before the game first writes to Storage. TrackHashes keeps a
+// hash per page so StateHash stays current at the cost of hashing every written page.
+static bool SnapshotInit(state_snapshots *Snapshots, void *Storage, uint64_t StorageSize, bool32 TrackHashes)
+{
+    *Snapshots = {};
+    Snapshots->Storage = (uint8_t *)Storage;
+    Snapshots->StorageSize = StorageSize;
+    Snapshots->PageSize = sysconf(_SC_PAGESIZE);
+    if ((Snapshots->PageSize % SNAPSHOT_HASH_CHUNK_SIZE) != 0 || (StorageSize % Snapshots->PageSize) != 0)
+    {
+        return false;
+    }
+    Snapshots->PageCount = (StorageSize + Snapshots->PageSize - 1) / Snapshots->PageSize;
+    Snapshots->MemoryFile = -1;
+    Snapshots->PageMapFile = -1;
+    Snapshots->TrackHashes = TrackHashes;
+
+    Snapshots->Residency = (uint8_t *)mmap(0, Snapshots->PageCount, PROT_READ | PROT_WRITE,
+                                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    Snapshots->PageDirty = (uint8_t *)mmap(0, Snapshots->PageCount, PROT_READ | PROT_WRITE,
+                                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    Snapshots->PageHashes = (uint64_t *)mmap(0, Snapshots->PageCount * sizeof(uint64_t), PROT_READ | PROT_WRITE,
+                                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (Snapshots->Residency == MAP_FAILED || Snapshots->PageDirty == MAP_FAILED ||
+        Snapshots->PageHashes == MAP_FAILED)
+    {
+        return false;
+    }
+
+    // NOTE: Slots are reserved up front but only the pages we actually copy into get committed.
+    // Storage and mirrors all start out zeroed, so no page differs yet.
+    for (int SlotIndex = 0; SlotIndex < SNAPSHOT_SLOT_COUNT; ++SlotIndex)
+    {
+        state_snapshot_slot *Slot = &Snapshots->Slots[SlotIndex];
+        Slot->Memory = (uint8_t *)mmap(0, StorageSize, PROT_READ | PROT_WRITE,
+                                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        Slot->PageChanged = (uint8_t *)mmap(0, Snapshots->PageCount, PROT_READ | PROT_WRITE,
+                                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (Slot->Memory == MAP_FAILED || Slot->PageChanged == MAP_FAILED)
+        {
+            return false;
+        }
+    }
+
+#if defined(__linux__)
+    if (!SnapshotInitDirtyTracking(Snapshots))
+    {
+        if (Snapshots->MemoryFile != -1)
+        {
+            close(Snapshots->MemoryFile);
+        }
+        if (Snapshots->PageMapFile != -1)
+        {
+            close(Snapshots->PageMapFile);
+        }
+        Snapshots->MemoryFile = -1;
+        Snapshots->PageMapFile = -1;
+    }
+#endif
+
+    return true;
+}
+
+// NOTE: Call for every page whose contents changed: refreshes its hash and marks it
+// as differing from every slot.
+// NOTE: Sum of the page's chunk hashes; an all-zero chunk contributes 0.
+static uint64_t SnapshotHashPage(state_snapshots *Snapshots, uint64_t PageIndex)
+{
+    uint64_t PageHash = 0;
+    uint64_t PageOffset = PageIndex * Snapshots->PageSize;
+    for (uint64_t Offset = PageOffset; Offset < PageOffset + Snapshots->PageSize; Offset += SNAPSHOT_HASH_CHUNK_SIZE)
+    {
+        uint8_t *Chunk = Snapshots->Storage + Offset;
+        if (!IsPageZero(Chunk, SNAPSHOT_HASH_CHUNK_SIZE))
+        {
+            PageHash += HashBytes(Chunk, SNAPSHOT_HASH_CHUNK_SIZE, Offset);
+        }
+    }
+    return(PageHash);
+}
+
+static void SnapshotTouchPage(state_snapshots *Snapshots, uint64_t PageIndex)
+{
+    if (Snapshots->TrackHashes)
+    {
+        uint64_t PageHash = SnapshotHashPage(Snapshots, PageIndex);
+        Snapshots->StateHash += PageHash - Snapshots->PageHashes[PageIndex];
+        Snapshots->PageHashes[PageIndex] = PageHash;
+    }
+
+    for (int SlotIndex = 0; SlotIndex < SNAPSHOT_SLOT_COUNT; ++SlotIndex)
+    {
+        Snapshots->Slots[SlotIndex].PageChanged[PageIndex] = 1;
+    }
+}
+
+// NOTE: Finds the pages written since the last call, so the cost follows how much the
+// game wrote, not how big the block is. Only call while nothing is writing to Storage.
+static uint64_t SnapshotCollectDirtyPages(state_snapshots *Snapshots)
+{
+    uint8_t *PageDirty = Snapshots->PageDirty;
+    bool Collected = false;
+
+#if defined(__linux__)
+    if (Snapshots->MemoryFile != -1 && SnapshotReadPageMap(Snapshots))
+    {
+        Collected = true;
+
+        uint64_t RunStart = 0;
+        uint64_t RunCount = 0;
+        for (uint64_t PageIndex = 0; PageIndex <= Snapshots->PageCount; ++PageIndex)
+        {
+            bool32 Written = (PageIndex < Snapshots->PageCount) && IsWrittenPage(Snapshots->PageMapEntries[PageIndex]);
+            if (PageIndex < Snapshots->PageCount)
+            {
+                PageDirty[PageIndex] = (uint8_t)Written;
+            }
+
+            if (Written)
+            {
+                if (RunCount == 0)
+                {
+                    RunStart = PageIndex;
+                }
+                ++RunCount;
+            }
+            else if (RunCount)
+            {
+                SnapshotCommitPages(Snapshots, Snapshots->Storage, RunStart, RunCount);
+                RunCount = 0;
+            }
+        }
+    }
+#endif
+
+    if (!Collected)
+    {
+        // NOTE: No dirty tracking, every page the game ever used counts as written.
+        SnapshotQueryResidency(Snapshots, PageDirty);
+    }
+
+    uint64_t DirtyPageCount = 0;
+    for (uint64_t PageIndex = 0; PageIndex < Snapshots->PageCount; ++PageIndex)
+    {
+        if (PageDirty[PageIndex])
+        {
+            SnapshotTouchPage(Snapshots, PageIndex);
+            ++DirtyPageCount;
+        }
+    }
+
+    Snapshots->DirtyPageCount = DirtyPageCount;
+    return(DirtyPageCount);
+}
+
+// NOTE: The hash only covers non-zero chunks, so it depends neither on which pages
+// happen to be resident nor on the page size, and is stable across save, load,
+// separate runs and hosts.
+static uint64_t HashGameState(state_snapshots *Snapshots)
+{
+    Assert(Snapshots->TrackHashes);
+    SnapshotCollectDirtyPages(Snapshots);
+    return(Snapshots->StateHash);
+}
+
+static void SnapshotSave(state_snapshots *Snapshots, int SlotIndex)
+{
+    Assert(SlotIndex >= 0 && SlotIndex < SNAPSHOT_SLOT_COUNT);
+    state_snapshot_slot *Slot = &Snapshots->Slots[SlotIndex];
+
+    SnapshotCollectDirtyPages(Snapshots);
+
+    uint64_t PagesCopied = 0;
+    for (uint64_t PageIndex = 0; PageIndex < Snapshots->PageCount; ++PageIndex)
+    {
+        if (Slot->PageChanged[PageIndex])
+        {
+            uint64_t Offset = PageIndex * Snapshots->PageSize;
+            memcpy(Slot->Memory + Offset, Snapshots->Storage + Offset, Snapshots->PageSize);
+            Slot->PageChanged[PageIndex] = 0;
+            ++PagesCopied;
+        }
+    }
+
+    Slot->PagesCopied = PagesCopied;
+    Slot->StateHash = Snapshots->StateHash;
+    Slot->IsValid = true;
+}
+
+// NOTE: Returns false if there is nothing in the slot or, when hashes are tracked, if
+// the restored state does not hash to what was saved. Only the restored pages are
+// rehashed, so the check is cheap.
+static bool SnapshotLoad(state_snapshots *Snapshots, int SlotIndex)
+{
+    Assert(SlotIndex >= 0 && SlotIndex < SNAPSHOT_SLOT_COUNT);
+    state_snapshot_slot *Slot = &Snapshots->Slots[SlotIndex];
+    if (!Slot->IsValid)
+    {
+        return false;
+    }
+
+    SnapshotCollectDirtyPages(Snapshots);
+
+    uint64_t PagesCopied = 0;
+    for (uint64_t PageIndex = 0; PageIndex < Snapshots->PageCount; ++PageIndex)
+    {
+        if (Slot->PageChanged[PageIndex])
+        {
+            uint64_t Offset = PageIndex * Snapshots->PageSize;
+            bool Restored = false;
+#if defined(__linux__)
+            // NOTE: Write straight into the backing file, so the page stays clean and
+            // the next collect does not pick it up again.
+            if (Snapshots->MemoryFile != -1)
+            {
+                Restored = SnapshotCommitPages(Snapshots, Slot->Memory, PageIndex, 1);
+            }
+#endif
+            if (!Restored)
+            {
+                memcpy(Snapshots->Storage + Offset, Slot->Memory + Offset, Snapshots->PageSize);
+            }
+            SnapshotTouchPage(Snapshots, PageIndex);
+            ++PagesCopied;
+        }
+    }
+
+    // NOTE: Storage matches this slot again; the other slots were marked by SnapshotTouchPage.
+    memset(Slot->PageChanged, 0, Snapshots->PageCount);
+    Slot->PagesCopied = PagesCopied;
+
+    return(!Snapshots->TrackHashes || Snapshots->StateHash == Slot->StateHash);
+}
@@ -0,0 +1,50 @@
+#ifndef EVERYDAY_SNAPSHOT_H
+
+#define SNAPSHOT_SLOT_COUNT 4
+
+// NOTE: A snapshot slot mirrors the persistent storage block page for page.
+// PageChanged marks the pages where the storage no longer matches the mirror,
+// so saving and loading only ever copy those.
+struct state_snapshot_slot
+{
+    uint8_t *Memory;
+    uint8_t *PageChanged;
+    uint64_t PagesCopied;
+    uint64_t StateHash;
+    bool32 IsValid;
+};
+
+struct state_snapshots
+{
+    uint8_t *Storage;
+    uint64_t StorageSize;
+    uint64_t PageSize;
+    uint64_t PageCount;
+
+    // NOTE: On Linux the storage is a MAP_PRIVATE mapping of MemoryFile, so written
+    // pages show up in /proc/self/pagemap as private copies until they are committed
+    // back to the file. Elsewhere (MemoryFile == -1) every resident page counts as
+    // written, found with mincore.
+    int MemoryFile;
+    int PageMapFile;
+    uint64_t *PageMapEntries;
+    uint8_t *Residency;
+
+    // NOTE: Pages written since the last SnapshotCollectDirtyPages.
+    uint8_t *PageDirty;
+    uint64_t DirtyPageCount;
+
+    // NOTE: Per-page hashes, only kept up to date when TrackHashes is set. Each is the
+    // sum of the page's 4 KiB chunk hashes, with zero chunks hashing to 0, and StateHash
+    // is the sum of all of them: it only depends on the bytes, not the page size, and
+    // can be updated one dirty page at a time.
+    bool32 TrackHashes;
+    uint64_t *PageHashes;
+    uint64_t StateHash;
+
+    int ActiveSlot;
+    state_snapshot_slot Slots[SNAPSHOT_SLOT_COUNT];
+};
+
+#define EVERYDAY_SNAPSHOT_H
+#endif // !EVERYDAY_SNAPSHOT_H
@@ -0,0 +1,121 @@
+#include "everyday_font.h"
+
+// NOTE: Debug text drawing straight into a game_offscreen_buffer, using the baked
+// 1-bit font. Glyph cells are FONT_GLYPH_WIDTH x FONT_GLYPH_HEIGHT pixels times
+// Scale, plus one scaled pixel of spacing on the right and bottom.
+
+inline int GetTextAdvanceX(int Scale)
+{
+    return((FONT_GLYPH_WIDTH + 1) * Scale);
+}
+
+inline int GetTextAdvanceY(int Scale)
+{
+    return((FONT_GLYPH_HEIGHT + 1) * Scale);
+}
+
+static void ClipRectangle(game_offscreen_buffer *Buffer, int *MinX, int *MinY, int *MaxX, int *MaxY)
+{
+    if (*MinX < 0) { *MinX = 0; }
+    if (*MinY < 0) { *MinY = 0; }
+    if (*MaxX > Buffer->Width) { *MaxX = Buffer->Width; }
+    if (*MaxY > Buffer->Height) { *MaxY = Buffer->Height; }
+}
+
+// NOTE: Halves every channel, so text stays readable over whatever the game drew.
+static void DarkenRectangle(game_offscreen_buffer *Buffer, int MinX, int MinY, int MaxX, int MaxY)
+{
+    ClipRectangle(Buffer, &MinX, &MinY, &MaxX, &MaxY);
+
+    uint8_t *Row = (uint8_t *)Buffer->Memory + MinY * Buffer->Pitch + MinX * 4;
+    for (int Y = MinY; Y < MaxY; ++Y)
+    {
+        uint32_t *Pixel = (uint32_t *)Row;
+        for (int X = MinX; X < MaxX; ++X)
+        {
+            *Pixel = (*Pixel >> 1) & 0x007F7F7F;
+            ++Pixel;
+        }
+        Row += Buffer->Pitch;
+    }
+}
+
+static void DrawGlyph(game_offscreen_buffer *Buffer, int X, int Y, int Scale, uint32_t Color, char Character)
+{
+    if (Character >= 'a' && Character <= 'z')
+    {
+        Character -= 'a' - 'A';
+    }
+    if (Character < FONT_FIRST_CHAR || Character > FONT_LAST_CHAR)
+    {
+        Character = '?';
+    }
+    const uint8_t *GlyphRows = FontGlyphRows[Character - FONT_FIRST_CHAR];
+
+    bool Clipped = (X < 0 || Y < 0 ||
+                    X + FONT_GLYPH_WIDTH * Scale > Buffer->Width ||
+                    Y + FONT_GLYPH_HEIGHT * Scale > Buffer->Height);
+
+    uint8_t *Row = (uint8_t *)Buffer->Memory + Y * Buffer->Pitch + X * 4;
+    for (int GlyphY = 0; GlyphY < FONT_GLYPH_HEIGHT; ++GlyphY)
+    {
+        uint8_t Bits = GlyphRows[GlyphY];
+        for (int RepeatY = 0; RepeatY < Scale; ++RepeatY)
+        {
+            if (Bits)
+            {
+                uint32_t *Pixel = (uint32_t *)Row;
+                for (int GlyphX = 0; GlyphX < FONT_GLYPH_WIDTH; ++GlyphX)
+                {
+                    if (Bits & (1 << (FONT_GLYPH_WIDTH - 1 - GlyphX)))
+                    {
+                        for (int RepeatX = 0; RepeatX < Scale; ++RepeatX)
+                        {
+                            if (!Clipped)
+                            {
+                                Pixel[RepeatX] = Color;
+                            }
+                            else
+                            {
+                                int PixelX = X + GlyphX * Scale + RepeatX;
+                                int PixelY = Y + GlyphY * Scale + RepeatY;
+                                if (PixelX >= 0 && PixelX < Buffer->Width &&
+                                    PixelY >= 0 && PixelY < Buffer->Height)
+                                {
+                                    Pixel[RepeatX] = Color;
+                                }
+                            }
+                        }
+                    }
+                    Pixel += Scale;
+                }
+            }
+            Row += Buffer->Pitch;
+        }
+    }
+}
+
+// NOTE: Handles '\n'. Returns the Y just below the last line drawn.
+static int DrawDebugText(game_offscreen_buffer *Buffer, int X, int Y, int Scale, uint32_t Color, const char *Text)
+{
+    int AtX = X;
+    for (const char *At = Text; *At; ++At)
+    {
+        if (*At == '\n')
+        {
+            AtX = X;
+            Y += GetTextAdvanceY(Scale);
+        }
+        else
+        {
+            if (*At != ' ' &&
+                AtX < Buffer->Width && AtX + FONT_GLYPH_WIDTH * Scale > 0 &&
+                Y < Buffer->Height && Y + FONT_GLYPH_HEIGHT * Scale > 0)
+            {
+                DrawGlyph(Buffer, AtX, Y, Scale, Color, *At);
+            }
+            AtX += GetTextAdvanceX(Scale);
+        }
+    }
+    return(Y + GetTextAdvanceY(Scale));
+}
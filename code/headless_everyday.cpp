@@ -0,0 +1,581 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "everyday.h"
+#include "everyday.cpp"
+#include "everyday_snapshot.cpp"
+#include "everyday_text.cpp"
+
+// NOTE: Headless platform layer. Runs GameUpdateAndRender with scripted input and no
+// window or audio device, so renderer and audio output can be compared frame for
+// frame against golden outputs recorded by an earlier run.
+
+#define HEADLESS_SAMPLES_PER_SECOND 48000
+#define HEADLESS_FRAMES_PER_SECOND 30
+
+struct headless_options
+{
+    int FrameCount;
+    int CheckpointEvery;
+    int Width;
+    int Height;
+    int VideoTolerance;
+    int SoundTolerance;
+    bool Checkpoint;
+    bool Text;
+    char *RecordPath;
+    char *CheckPath;
+};
+
+struct headless_hashes
+{
+    uint64_t Video;
+    uint64_t Sound;
+    uint64_t State;
+};
+
+#if EVERYDAY_INTERNAL
+// NOTE: Headless runs never touch the filesystem on the game's behalf.
+static debug_read_file_result DEBUGPlatformReadEntireFile(char *Filename)
+{
+    debug_read_file_result Result = {};
+    return(Result);
+}
+
+static void DEBUGPlatformFreeFileMemory(void *Memory)
+{
+}
+
+static bool32 DEBUGPlatformWriteEntireFile(char *Filename, uint32_t MemorySize, void *Memory)
+{
+    return true;
+}
+#endif
+
+static uint64_t HeadlessGetNanoseconds()
+{
+    timespec Now;
+    clock_gettime(CLOCK_MONOTONIC, &Now);
+    return((uint64_t)Now.tv_sec * 1000000000ULL + (uint64_t)Now.tv_nsec);
+}
+
+// NOTE: Input is a pure function of the frame index so every run sees the same script.
+static void HeadlessScriptInput(int FrameIndex, game_input *OldInput, game_input *NewInput)
+{
+    game_controller_input *OldController = &OldInput->Controllers[0];
+    game_controller_input *NewController = &NewInput->Controllers[0];
+
+    NewController->IsAnalog = true;
+    NewController->EndX = (float)((FrameIndex % 60) - 30) / 30.0f;
+    NewController->EndY = (float)((FrameIndex % 90) - 45) / 45.0f;
+    NewController->MinX = NewController->MaxX = NewController->EndX;
+    NewController->MinY = NewController->MaxY = NewController->EndY;
+
+    NewController->Down.EndedDown = ((FrameIndex / 20) % 2) == 1;
+    NewController->Down.HalfTransitionCount =
+        (NewController->Down.EndedDown == OldController->Down.EndedDown) ? 0 : 1;
+}
+
+static bool HeadlessWriteFile(char *Filename, void *Header, int HeaderSize, void *Memory, uint64_t MemorySize)
+{
+    FILE *File = fopen(Filename, "wb");
+    if (!File)
+    {
+        fprintf(stderr, "Couldn't open %s for writing\n", Filename);
+        return false;
+    }
+
+    bool Result = ((fwrite(Header, 1, HeaderSize, File) == (size_t)HeaderSize) &&
+                   (fwrite(Memory, 1, MemorySize, File) == MemorySize));
+    fclose(File);
+    return(Result);
+}
+
+// NOTE: Reads exactly MemorySize bytes following the expected header, which also
+// catches goldens recorded at a different buffer size.
+static bool HeadlessReadFile(char *Filename, char *Header, int HeaderSize, void *Memory, uint64_t MemorySize)
+{
+    FILE *File = fopen(Filename, "rb");
+    if (!File)
+    {
+        fprintf(stderr, "Couldn't open golden file %s\n", Filename);
+        return false;
+    }
+
+    char FileHeader[64];
+    bool Result = ((HeaderSize <= (int)sizeof(FileHeader)) &&
+                   (fread(FileHeader, 1, HeaderSize, File) == (size_t)HeaderSize) &&
+                   (memcmp(FileHeader, Header, HeaderSize) == 0) &&
+                   (fread(Memory, 1, MemorySize, File) == MemorySize) &&
+                   (fgetc(File) == EOF));
+    fclose(File);
+    if (!Result)
+    {
+        fprintf(stderr, "Golden file %s does not match the current buffer layout\n", Filename);
+    }
+    return(Result);
+}
+
+// NOTE: Golden video frames are binary PPMs so they can be opened in any image viewer.
+static void HeadlessBufferToRGB(game_offscreen_buffer *Buffer, uint8_t *RGB)
+{
+    uint8_t *Row = (uint8_t *)Buffer->Memory;
+    for (int Y = 0; Y < Buffer->Height; ++Y)
+    {
+        uint32_t *Pixel = (uint32_t *)Row;
+        for (int X = 0; X < Buffer->Width; ++X)
+        {
+            uint32_t Color = *Pixel++;
+            *RGB++ = (uint8_t)(Color >> 16);
+            *RGB++ = (uint8_t)(Color >> 8);
+            *RGB++ = (uint8_t)(Color >> 0);
+        }
+        Row += Buffer->Pitch;
+    }
+}
+
+static int HeadlessPPMHeader(char *Header, int HeaderSize, game_offscreen_buffer *Buffer)
+{
+    return(snprintf(Header, HeaderSize, "P6\n%d %d\n255\n", Buffer->Width, Buffer->Height));
+}
+
+static int HeadlessMaxDifference(uint8_t *A, uint8_t *B, uint64_t Count)
+{
+    int Result = 0;
+    for (uint64_t Index = 0; Index < Count; ++Index)
+    {
+        int Difference = abs((int)A[Index] - (int)B[Index]);
+        if (Difference > Result)
+        {
+            Result = Difference;
+        }
+    }
+    return(Result);
+}
+
+static int HeadlessMaxDifference(int16_t *A, int16_t *B, uint64_t Count)
+{
+    int Result = 0;
+    for (uint64_t Index = 0; Index < Count; ++Index)
+    {
+        int Difference = abs((int)A[Index] - (int)B[Index]);
+        if (Difference > Result)
+        {
+            Result = Difference;
+        }
+    }
+    return(Result);
+}
+
+static void HeadlessFormatHashes(char *Line, int LineSize, int FrameIndex, headless_hashes *Hashes)
+{
+    snprintf(Line, LineSize, "frame %04d video %016llx sound %016llx state %016llx\n", FrameIndex,
+             (unsigned long long)Hashes->Video, (unsigned long long)Hashes->Sound, (unsigned long long)Hashes->State);
+}
+
+// NOTE: The state hash has to match exactly; it only depends on the state bytes, not
+// on the host's page size, so goldens carry across machines. The video and sound
+// hashes only have to match when their tolerance is 0; otherwise the
+// sample-by-sample comparison decides.
+static bool HeadlessCheckHashes(headless_options *Options, FILE *GoldenHashes, int FrameIndex, headless_hashes *Hashes)
+{
+    char Line[256];
+    int GoldenFrameIndex = -1;
+    unsigned long long Video = 0;
+    unsigned long long Sound = 0;
+    unsigned long long State = 0;
+    if (!fgets(Line, sizeof(Line), GoldenHashes) ||
+        sscanf(Line, "frame %d video %llx sound %llx state %llx", &GoldenFrameIndex, &Video, &Sound, &State) != 4 ||
+        GoldenFrameIndex != FrameIndex)
+    {
+        fprintf(stderr, "frame %d: no matching line in the golden hashes\n", FrameIndex);
+        return false;
+    }
+
+    bool Result = true;
+    if (Hashes->State != State)
+    {
+        fprintf(stderr, "frame %d: MISMATCH state hash %016llx, golden %016llx\n",
+                FrameIndex, (unsigned long long)Hashes->State, State);
+        Result = false;
+    }
+    if (Options->VideoTolerance == 0 && Hashes->Video != Video)
+    {
+        fprintf(stderr, "frame %d: MISMATCH video hash %016llx, golden %016llx\n",
+                FrameIndex, (unsigned long long)Hashes->Video, Video);
+        Result = false;
+    }
+    if (Options->SoundTolerance == 0 && Hashes->Sound != Sound)
+    {
+        fprintf(stderr, "frame %d: MISMATCH sound hash %016llx, golden %016llx\n",
+                FrameIndex, (unsigned long long)Hashes->Sound, Sound);
+        Result = false;
+    }
+    return(Result);
+}
+
+static bool HeadlessProcessCheckpoint(headless_options *Options, int FrameIndex, headless_hashes *Hashes, FILE *HashFile,
+                                      game_offscreen_buffer *Buffer, game_sound_output_buffer *SoundBuffer,
+                                      uint8_t *RGB, uint8_t *GoldenRGB, int16_t *GoldenSamples)
+{
+    bool Result = true;
+
+    uint64_t RGBSize = (uint64_t)Buffer->Width * Buffer->Height * 3;
+    uint64_t SampleValueCount = (uint64_t)SoundBuffer->SampleCount * 2;
+    uint64_t SoundSize = SampleValueCount * sizeof(int16_t);
+
+    HeadlessBufferToRGB(Buffer, RGB);
+
+    char Header[64];
+    int HeaderSize = HeadlessPPMHeader(Header, sizeof(Header), Buffer);
+
+    char VideoPath[4096];
+    char SoundPath[4096];
+    char *Directory = Options->RecordPath ? Options->RecordPath : Options->CheckPath;
+    if (Directory)
+    {
+        snprintf(VideoPath, sizeof(VideoPath), "%s/frame_%04d.ppm", Directory, FrameIndex);
+        snprintf(SoundPath, sizeof(SoundPath), "%s/frame_%04d.pcm", Directory, FrameIndex);
+    }
+
+    if (Options->RecordPath)
+    {
+        char Line[256];
+        HeadlessFormatHashes(Line, sizeof(Line), FrameIndex, Hashes);
+        Result = (HeadlessWriteFile(VideoPath, Header, HeaderSize, RGB, RGBSize) &&
+                  HeadlessWriteFile(SoundPath, Header, 0, SoundBuffer->Samples, SoundSize) &&
+                  fputs(Line, HashFile) >= 0);
+    }
+    else if (Options->CheckPath)
+    {
+        Result = HeadlessCheckHashes(Options, HashFile, FrameIndex, Hashes);
+
+        if (HeadlessReadFile(VideoPath, Header, HeaderSize, GoldenRGB, RGBSize) &&
+            HeadlessReadFile(SoundPath, Header, 0, GoldenSamples, SoundSize))
+        {
+            int VideoDifference = HeadlessMaxDifference(RGB, GoldenRGB, RGBSize);
+            int SoundDifference = HeadlessMaxDifference(SoundBuffer->Samples, GoldenSamples, SampleValueCount);
+            if (VideoDifference > Options->VideoTolerance || SoundDifference > Options->SoundTolerance)
+            {
+                fprintf(stderr, "frame %d: MISMATCH video max diff %d (tolerance %d), sound max diff %d (tolerance %d)\n",
+                        FrameIndex, VideoDifference, Options->VideoTolerance, SoundDifference, Options->SoundTolerance);
+                Result = false;
+            }
+        }
+        else
+        {
+            Result = false;
+        }
+    }
+
+    return(Result);
+}
+
+static bool HeadlessParseOptions(int ArgCount, char **Args, headless_options *Options)
+{
+    Options->FrameCount = 120;
+    Options->CheckpointEvery = 30;
+    Options->Width = 640;
+    Options->Height = 480;
+
+    for (int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+    {
+        char *Arg = Args[ArgIndex];
+        if (strcmp(Arg, "--checkpoint") == 0)
+        {
+            Options->Checkpoint = true;
+            continue;
+        }
+        if (strcmp(Arg, "--text") == 0)
+        {
+            Options->Text = true;
+            continue;
+        }
+
+        char *Value = (ArgIndex + 1 < ArgCount) ? Args[ArgIndex + 1] : 0;
+        if (!Value)
+        {
+            fprintf(stderr, "Missing value for %s\n", Arg);
+            return false;
+        }
+        ++ArgIndex;
+
+        if (strcmp(Arg, "--frames") == 0) { Options->FrameCount = atoi(Value); }
+        else if (strcmp(Arg, "--every") == 0) { Options->CheckpointEvery = atoi(Value); }
+        else if (strcmp(Arg, "--width") == 0) { Options->Width = atoi(Value); }
+        else if (strcmp(Arg, "--height") == 0) { Options->Height = atoi(Value); }
+        else if (strcmp(Arg, "--video-tolerance") == 0) { Options->VideoTolerance = atoi(Value); }
+        else if (strcmp(Arg, "--sound-tolerance") == 0) { Options->SoundTolerance = atoi(Value); }
+        else if (strcmp(Arg, "--record") == 0) { Options->RecordPath = Value; }
+        else if (strcmp(Arg, "--check") == 0) { Options->CheckPath = Value; }
+        else
+        {
+            fprintf(stderr, "Unknown option %s\n", Arg);
+            return false;
+        }
+    }
+
+    if (Options->FrameCount <= 0 || Options->CheckpointEvery <= 0 ||
+        Options->Width <= 0 || Options->Height <= 0)
+    {
+        fprintf(stderr, "Frame count, checkpoint interval and buffer size must be positive\n");
+        return false;
+    }
+
+    if (Options->RecordPath && Options->CheckPath)
+    {
+        fprintf(stderr, "--record and --check can't be used together\n");
+        return false;
+    }
+
+    if (Options->VideoTolerance < 0 || Options->SoundTolerance < 0)
+    {
+        fprintf(stderr, "Tolerances can't be negative\n");
+        return false;
+    }
+
+    return true;
+}
+
+// NOTE: Draws fixed debug text into a small buffer, with strings hanging over every
+// edge so the clipped glyph path is covered, and records or checks it as text.ppm.
+// Independent of the game and of --width/--height.
+static bool HeadlessRunTextCheck(headless_options *Options)
+{
+    game_offscreen_buffer Buffer = {};
+    Buffer.Width = 64;
+    Buffer.Height = 32;
+    Buffer.Pitch = Buffer.Width * 4;
+    Buffer.Memory = calloc((size_t)Buffer.Height, Buffer.Pitch);
+
+    uint32_t *Pixel = (uint32_t *)Buffer.Memory;
+    for (int PixelIndex = 0; PixelIndex < Buffer.Width * Buffer.Height; ++PixelIndex)
+    {
+        *Pixel++ = 0x00406080;
+    }
+
+    DarkenRectangle(&Buffer, -4, -4, 40, 12);
+    DrawDebugText(&Buffer, 2, 2, 1, 0x00FFFF80, "Hi 0:9?");
+    DrawDebugText(&Buffer, -3, 14, 1, 0x00FF0000, "LEFT");
+    DrawDebugText(&Buffer, 50, 18, 2, 0x0000FF00, "RIGHT\nEDGE");
+    DrawDebugText(&Buffer, 20, -5, 1, 0x000000FF, "TOP~");
+
+    uint64_t VideoHash = HashBytes(Buffer.Memory, (uint64_t)Buffer.Pitch * Buffer.Height, 0);
+    printf("text video %016llx\n", (unsigned long long)VideoHash);
+
+    uint64_t RGBSize = (uint64_t)Buffer.Width * Buffer.Height * 3;
+    uint8_t *RGB = (uint8_t *)malloc(RGBSize);
+    uint8_t *GoldenRGB = (uint8_t *)malloc(RGBSize);
+    HeadlessBufferToRGB(&Buffer, RGB);
+
+    char Header[64];
+    int HeaderSize = HeadlessPPMHeader(Header, sizeof(Header), &Buffer);
+
+    bool Result = true;
+    char Path[4096];
+    if (Options->RecordPath)
+    {
+        mkdir(Options->RecordPath, 0755);
+        snprintf(Path, sizeof(Path), "%s/text.ppm", Options->RecordPath);
+        Result = HeadlessWriteFile(Path, Header, HeaderSize, RGB, RGBSize);
+    }
+    else if (Options->CheckPath)
+    {
+        snprintf(Path, sizeof(Path), "%s/text.ppm", Options->CheckPath);
+        Result = HeadlessReadFile(Path, Header, HeaderSize, GoldenRGB, RGBSize);
+        if (Result)
+        {
+            int VideoDifference = HeadlessMaxDifference(RGB, GoldenRGB, RGBSize);
+            if (VideoDifference > Options->VideoTolerance)
+            {
+                fprintf(stderr, "text: MISMATCH video max diff %d (tolerance %d)\n",
+                        VideoDifference, Options->VideoTolerance);
+                Result = false;
+            }
+        }
+        printf("%s\n", Result ? "PASSED" : "FAILED");
+    }
+
+    free(GoldenRGB);
+    free(RGB);
+    free(Buffer.Memory);
+    return(Result);
+}
+
+int main(int ArgCount, char **Args)
+{
+    headless_options Options = {};
+    if (!HeadlessParseOptions(ArgCount, Args, &Options))
+    {
+        fprintf(stderr, "Usage: %s [--frames N] [--every N] [--width W] [--height H] [--checkpoint | --text]\n"
+                        "          [--record DIR | --check DIR [--video-tolerance N] [--sound-tolerance N]]\n", Args[0]);
+        return 2;
+    }
+
+    if (Options.Text)
+    {
+        return(HeadlessRunTextCheck(&Options) ? 0 : 1);
+    }
+
+    // NOTE: The hashes printed at every checkpoint are recorded alongside the goldens.
+    FILE *HashFile = 0;
+    char *HashDirectory = Options.RecordPath ? Options.RecordPath : Options.CheckPath;
+    if (HashDirectory)
+    {
+        if (Options.RecordPath)
+        {
+            mkdir(Options.RecordPath, 0755);
+        }
+
+        char HashPath[4096];
+        snprintf(HashPath, sizeof(HashPath), "%s/hashes.txt", HashDirectory);
+        HashFile = fopen(HashPath, Options.RecordPath ? "w" : "r");
+        if (!HashFile)
+        {
+            fprintf(stderr, "Couldn't open %s\n", HashPath);
+            return 1;
+        }
+    }
+
+    game_memory GameMemory = {};
+    GameMemory.PersistentStorageSize = Megabytes(64);
+    GameMemory.TransientStorageSize = Megabytes(64);
+
+    uint64_t TotalStorageSize = GameMemory.PersistentStorageSize + GameMemory.TransientStorageSize;
+    GameMemory.PersistentStorage = mmap(0, TotalStorageSize, PROT_READ | PROT_WRITE,
+                                        MAP_ANON | MAP_PRIVATE, -1, 0);
+    if (GameMemory.PersistentStorage == MAP_FAILED)
+    {
+        fprintf(stderr, "Couldn't allocate game memory\n");
+        return 1;
+    }
+    GameMemory.TransientStorage = (uint8_t *)(GameMemory.PersistentStorage) + GameMemory.PersistentStorageSize;
+
+    state_snapshots Snapshots = {};
+    if (!SnapshotInit(&Snapshots, GameMemory.PersistentStorage, GameMemory.PersistentStorageSize, true))
+    {
+        fprintf(stderr, "Couldn't set up state hashing\n");
+        return 1;
+    }
+
+    game_offscreen_buffer Buffer = {};
+    Buffer.Width = Options.Width;
+    Buffer.Height = Options.Height;
+    Buffer.Pitch = Options.Width * 4;
+    Buffer.Memory = calloc((size_t)Buffer.Height, Buffer.Pitch);
+
+    game_sound_output_buffer SoundBuffer = {};
+    SoundBuffer.SamplesPerSecond = HEADLESS_SAMPLES_PER_SECOND;
+    SoundBuffer.SampleCount = HEADLESS_SAMPLES_PER_SECOND / HEADLESS_FRAMES_PER_SECOND;
+    SoundBuffer.Samples = (int16_t *)calloc(SoundBuffer.SampleCount, 2 * sizeof(int16_t));
+
+    uint8_t *RGB = (uint8_t *)malloc((size_t)Buffer.Width * Buffer.Height * 3);
+    uint8_t *GoldenRGB = (uint8_t *)malloc((size_t)Buffer.Width * Buffer.Height * 3);
+    int16_t *GoldenSamples = (int16_t *)malloc((size_t)SoundBuffer.SampleCount * 2 * sizeof(int16_t));
+
+    game_input Input[2] = {};
+    game_input *NewInput = &Input[0];
+    game_input *OldInput = &Input[1];
+
+    int Failures = 0;
+    uint64_t GameNanoseconds = 0;
+    uint64_t SaveNanoseconds = 0;
+    uint64_t LoadNanoseconds = 0;
+    int CheckpointCount = 0;
+    int Desyncs = 0;
+
+    for (int FrameIndex = 0; FrameIndex < Options.FrameCount; ++FrameIndex)
+    {
+        HeadlessScriptInput(FrameIndex, OldInput, NewInput);
+
+        // NOTE: Checkpoint mode saves the state before each frame, then rolls back and
+        // replays the frame, which must land on the same state hash. Nothing is worth
+        // saving until the game has initialized its state on frame 0.
+        bool Checkpoint = Options.Checkpoint && FrameIndex > 0;
+        if (Checkpoint)
+        {
+            uint64_t SaveStart = HeadlessGetNanoseconds();
+            SnapshotSave(&Snapshots, 0);
+            SaveNanoseconds += HeadlessGetNanoseconds() - SaveStart;
+        }
+
+        uint64_t StartTime = HeadlessGetNanoseconds();
+        GameUpdateAndRender(&GameMemory, NewInput, &Buffer);
+        GameNanoseconds += HeadlessGetNanoseconds() - StartTime;
+
+        if (Checkpoint)
+        {
+            uint64_t FrameHash = HashGameState(&Snapshots);
+
+            uint64_t LoadStart = HeadlessGetNanoseconds();
+            bool Restored = SnapshotLoad(&Snapshots, 0);
+            LoadNanoseconds += HeadlessGetNanoseconds() - LoadStart;
+
+            GameUpdateAndRender(&GameMemory, NewInput, &Buffer);
+            if (!Restored || HashGameState(&Snapshots) != FrameHash)
+            {
+                fprintf(stderr, "frame %d: DESYNC after restoring the checkpoint\n", FrameIndex);
+                ++Desyncs;
+            }
+            ++CheckpointCount;
+        }
+
+        StartTime = HeadlessGetNanoseconds();
+        GameGetSoundSamples(&GameMemory, &SoundBuffer);
+        GameNanoseconds += HeadlessGetNanoseconds() - StartTime;
+
+        game_input *Temp = NewInput;
+        NewInput = OldInput;
+        OldInput = Temp;
+
+        if ((FrameIndex % Options.CheckpointEvery) == 0 || FrameIndex == Options.FrameCount - 1)
+        {
+            headless_hashes Hashes = {};
+            uint8_t *Row = (uint8_t *)Buffer.Memory;
+            for (int Y = 0; Y < Buffer.Height; ++Y)
+            {
+                Hashes.Video = HashBytes(Row, (uint64_t)Buffer.Width * 4, Hashes.Video);
+                Row += Buffer.Pitch;
+            }
+            Hashes.Sound = HashBytes(SoundBuffer.Samples, (uint64_t)SoundBuffer.SampleCount * 2 * sizeof(int16_t), 0);
+            Hashes.State = HashGameState(&Snapshots);
+
+            char Line[256];
+            HeadlessFormatHashes(Line, sizeof(Line), FrameIndex, &Hashes);
+            fputs(Line, stdout);
+
+            if (!HeadlessProcessCheckpoint(&Options, FrameIndex, &Hashes, HashFile, &Buffer, &SoundBuffer,
+                                           RGB, GoldenRGB, GoldenSamples))
+            {
+                ++Failures;
+            }
+        }
+    }
+
+    double MSPerFrame = ((double)GameNanoseconds / 1000000.0) / (double)Options.FrameCount;
+    printf("%d frames, %.04f ms/f in GameUpdateAndRender and GameGetSoundSamples\n", Options.FrameCount, MSPerFrame);
+
+    if (HashFile)
+    {
+        fclose(HashFile);
+    }
+
+    if (CheckpointCount)
+    {
+        printf("%d checkpoints, %.04f ms/f in SnapshotSave, %.04f ms/f in SnapshotLoad, %d desyncs\n", CheckpointCount,
+               ((double)SaveNanoseconds / 1000000.0) / (double)CheckpointCount,
+               ((double)LoadNanoseconds / 1000000.0) / (double)CheckpointCount, Desyncs);
+    }
+
+    if (Options.CheckPath)
+    {
+        printf("%s\n", (Failures || Desyncs) ? "FAILED" : "PASSED");
+    }
+
+    return((Failures || Desyncs) ? 1 : 0);
+}
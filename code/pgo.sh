@@ -0,0 +1,83 @@
+#!/bin/sh
+
+# Builds the headless driver in every release configuration, trains a
+# profile-guided build on a headless run of GameUpdateAndRender, and reports
+# ms/frame and speedup over the debug build for each.
+#
+# Usage (from code/, like build.sh): ./pgo.sh [frames]
+# CXX selects the compiler. With Clang, the profile is also applied to the game
+# itself (everyday_release_pgo) when SDL3 is available; GCC can't reuse it there.
+
+FRAMES=${1:-600}
+CXX=${CXX:-cc}
+RELEASE="-DEVERYDAY_INTERNAL=0 -DEVERYDAY_SLOW=0"
+NATIVE="-O3 -march=native"
+
+set -e
+
+mkdir -p ../build
+cd ../build
+rm -rf pgo
+mkdir -p pgo
+
+build() {
+    Name=$1
+    shift
+    $CXX ../code/headless_everyday.cpp "$@" -lm -o everyday_headless_$Name
+}
+
+# NOTE: Best of three runs, to keep scheduler noise out of the comparison.
+bench() {
+    Best=""
+    for Run in 1 2 3; do
+        MS=$(./everyday_headless_$1 --frames $FRAMES | sed -n 's/.* \([0-9.]*\) ms\/f.*/\1/p')
+        if [ -z "$Best" ]; then
+            Best=$MS
+        else
+            Best=$(echo "$Best $MS" | awk '{ print ($2 < $1) ? $2 : $1 }')
+        fi
+    done
+    echo $Best
+}
+
+if $CXX --version | grep -q clang; then
+    IS_CLANG=1
+fi
+
+echo "Building with $CXX"
+build debug -g -DEVERYDAY_INTERNAL=1 -DEVERYDAY_SLOW=1
+build release -O2 $RELEASE
+build release_native $NATIVE $RELEASE
+build release_lto $NATIVE -flto $RELEASE
+
+echo "Training PGO profile on $FRAMES headless frames"
+if [ -n "$IS_CLANG" ]; then
+    build release_pgo $NATIVE -flto $RELEASE -fprofile-instr-generate
+    LLVM_PROFILE_FILE=pgo/headless-%p.profraw ./everyday_headless_release_pgo --frames $FRAMES > /dev/null
+    llvm-profdata merge -output=pgo/everyday.profdata pgo/*.profraw
+    PGO_USE="-fprofile-instr-use=pgo/everyday.profdata -Wno-profile-instr-unprofiled"
+else
+    build release_pgo $NATIVE -flto $RELEASE -fprofile-generate=pgo -fprofile-update=atomic
+    ./everyday_headless_release_pgo --frames $FRAMES > /dev/null
+    PGO_USE="-fprofile-use=pgo -fprofile-correction -Wmissing-profile"
+fi
+build release_pgo $NATIVE -flto $RELEASE $PGO_USE
+
+# NOTE: Clang matches profiles by function name, so the headless training run also
+# covers the game code in the SDL build. GCC profiles are per object file and the
+# game is a separate unity build, so there is no GCC profile for it.
+if [ -z "$IS_CLANG" ]; then
+    echo "Skipping everyday_release_pgo: GCC has no profile for the game, only for the headless build"
+elif pkg-config --exists sdl3; then
+    $CXX ../code/sdl_everyday.cpp $NATIVE -flto $RELEASE $PGO_USE $(pkg-config --libs --cflags sdl3) -o everyday_release_pgo
+fi
+
+echo
+printf "%-16s %10s %8s\n" "configuration" "ms/frame" "speedup"
+for Config in debug release release_native release_lto release_pgo; do
+    MS=$(bench $Config)
+    if [ $Config = debug ]; then
+        BASELINE=$MS
+    fi
+    printf "%-16s %10s %7sx\n" $Config $MS $(echo "$BASELINE $MS" | awk '{ printf "%.2f", $1 / $2 }')
+done
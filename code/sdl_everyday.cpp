@@ -8,9 +8,12 @@
 #include "SDL3/SDL_keycode.h"
 #include "SDL3/SDL_render.h"
 #include "SDL3/SDL_stdinc.h"
+#include "SDL3/SDL_thread.h"
+#include "SDL3/SDL_mutex.h"
 #include "SDL3/SDL_video.h"
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_main.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <sys/mman.h>
 #include <unistd.h>
@@ -20,6 +23,8 @@
 
 #include "everyday.h"
 #include "everyday.cpp"
+#include "everyday_snapshot.cpp"
+#include "everyday_text.cpp"
 #include "sdl_everyday.h"
 
 #include <cstring>
@@ -28,13 +33,39 @@
 SDL_Gamepad *ControllerHandles[MAX_CONTROLLERS];
 SDL_Haptic *RumbleHandles[MAX_CONTROLLERS];
 
-sdl_audio_ring_buffer AudioRingBuffer;
-
 static bool GlobalRunning;
-static game_offscreen_buffer GlobalBackBuffer;
+// NOTE: The game renders into one back buffer while the other is uploaded and
+// presented, so present-time stalls overlap with simulation instead of adding to it.
+static game_offscreen_buffer GlobalBackBuffers[2];
+static int GlobalPresentBufferIndex;
+// NOTE: Set when the back buffers were reallocated and hold nothing at the new size yet.
+static bool GlobalBackBuffersResized;
+// NOTE: With GlobalPipelined set, frame N+1 is simulated on the game thread while
+// frame N is uploaded and presented here, at the cost of one frame of latency.
+// F2 or --serial switches to running and presenting each frame in turn.
+static bool GlobalPipelined = true;
+static SDL_Texture *GlobalDisplayTexture;
 static SDL_Joystick *GlobalJoystick;
-static SDL_AudioStream *GlobalStream;
+static sdl_audio_thread GlobalAudioThread;
+static state_snapshots GlobalSnapshots;
+static uint64_t GlobalFrameIndex;
+#if EVERYDAY_INTERNAL
+static uint64_t GlobalStateHash;
+#endif
+static bool GlobalShowDebugOverlay = true;
+static sdl_debug_stats GlobalDebugStats;
+
+static const char *DebugTimerNames[DebugTimer_Count] =
+{
+    "Game",
+    "Wait for game",
+    "Events",
+    "Input",
+    "Present",
+    "Overlay",
+};
 
+#if EVERYDAY_INTERNAL
 static debug_read_file_result DEBUGPlatformReadEntireFile(char *Filename)
 {
     debug_read_file_result Result = {};
@@ -115,6 +146,7 @@ DEBUGPlatformWriteEntireFile(char *Filename, uint32_t MemorySize, void *Memory)
 
     return true;
 }
+#endif
 
 sdl_window_dimension SDLGetWindowDimension(SDL_Window *Window) {
     sdl_window_dimension Result;
@@ -124,59 +156,41 @@ sdl_window_dimension SDLGetWindowDimension(SDL_Window *Window) {
     return Result;
 }
 
-static void DisplayBufferInWindow(SDL_Renderer *Renderer) {
+static void DisplayBufferInWindow(SDL_Renderer *Renderer, game_offscreen_buffer *Buffer) {
+    // NOTE: Reuse the streaming texture across frames; only recreate it when the buffer size changes.
+    if (!GlobalDisplayTexture ||
+        GlobalDisplayTexture->w != Buffer->Width ||
+        GlobalDisplayTexture->h != Buffer->Height)
+    {
+        if (GlobalDisplayTexture) {
+            SDL_DestroyTexture(GlobalDisplayTexture);
+        }
+        GlobalDisplayTexture = SDL_CreateTexture(Renderer, SDL_PIXELFORMAT_XRGB8888, SDL_TEXTUREACCESS_STREAMING, Buffer->Width, Buffer->Height);
+    }
+
     SDL_RenderClear(Renderer);
-    SDL_Texture *Texture = SDL_CreateTexture(Renderer, SDL_PIXELFORMAT_XRGB8888, SDL_TEXTUREACCESS_STREAMING, GlobalBackBuffer.Width, GlobalBackBuffer.Height);
-    SDL_UpdateTexture(Texture, NULL, GlobalBackBuffer.Memory, GlobalBackBuffer.Pitch);
-    SDL_RenderTexture(Renderer, Texture, NULL, NULL);
+    SDL_UpdateTexture(GlobalDisplayTexture, NULL, Buffer->Memory, Buffer->Pitch);
+    SDL_RenderTexture(Renderer, GlobalDisplayTexture, NULL, NULL);
     SDL_RenderPresent(Renderer);
 }
 
 static void ResizeTexture(SDL_Renderer *Renderer, int Width, int Height) {
     int BytesPerPixel = 4;
 
-    GlobalBackBuffer.Pitch = Width * BytesPerPixel;
+    // NOTE: Only called while the game thread is idle, so both buffers can be swapped out.
+    for (int BufferIndex = 0; BufferIndex < (int)ArrayCount(GlobalBackBuffers); ++BufferIndex) {
+        game_offscreen_buffer *BackBuffer = &GlobalBackBuffers[BufferIndex];
 
-    if (GlobalBackBuffer.Memory) {
-        munmap(GlobalBackBuffer.Memory, GlobalBackBuffer.Width * GlobalBackBuffer.Height * BytesPerPixel);
-    }
-    GlobalBackBuffer.Width = Width;
-    GlobalBackBuffer.Height = Height;
-    GlobalBackBuffer.Memory = mmap(0, Width * Height * BytesPerPixel, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-}
-
-static void SDLFillSoundBuffer(sdl_sound_output *SoundOutput, int ByteToLock, int BytesToWrite, game_sound_output_buffer *SoundBuffer)
-{
-    int16_t *Samples = SoundBuffer->Samples;
-    void *Region1 = (uint8_t*)AudioRingBuffer.Data + ByteToLock;
-    int Region1Size = BytesToWrite;
-    if (Region1Size + ByteToLock > SoundOutput->SecondaryBufferSize)
-    {
-        Region1Size = SoundOutput->SecondaryBufferSize - ByteToLock;
-    }
-    void *Region2 = AudioRingBuffer.Data;
-    int Region2Size = BytesToWrite - Region1Size;
-    int Region1SampleCount = Region1Size/SoundOutput->BytesPerSample;
-    int16_t *SampleOut = (int16_t *)Region1;
-    for(int SampleIndex = 0;
-        SampleIndex < Region1SampleCount;
-        ++SampleIndex)
-    {
-        *SampleOut++ = *Samples++;
-        *SampleOut++ = *Samples++;
-        ++SoundOutput->RunningSampleIndex;
-    }
+        BackBuffer->Pitch = Width * BytesPerPixel;
 
-    int Region2SampleCount = Region2Size/SoundOutput->BytesPerSample;
-    SampleOut = (int16_t *)Region2;
-    for(int SampleIndex = 0;
-        SampleIndex < Region2SampleCount;
-        ++SampleIndex)
-    {
-        *SampleOut++ = *Samples++;
-        *SampleOut++ = *Samples++;
-        ++SoundOutput->RunningSampleIndex;
+        if (BackBuffer->Memory) {
+            munmap(BackBuffer->Memory, BackBuffer->Width * BackBuffer->Height * BytesPerPixel);
+        }
+        BackBuffer->Width = Width;
+        BackBuffer->Height = Height;
+        BackBuffer->Memory = mmap(0, Width * Height * BytesPerPixel, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
     }
+    GlobalBackBuffersResized = true;
 }
 
 static void SDLProcessGameControllerButton(game_button_state *OldState,
@@ -189,52 +203,309 @@ static void SDLProcessGameControllerButton(game_button_state *OldState,
 }
 
 
-static void SDLAudioCallback(void *UserData, SDL_AudioStream *Stream, int AdditionalAmount, int TotalAmount)
+// NOTE: Called on SDL's device thread whenever it pulls from the stream.
+// AdditionalAmount is how many bytes it wanted beyond what was queued, so anything
+// above zero means the device ran dry.
+static void SDLCALL SDLAudioStreamGetCallback(void *UserData, SDL_AudioStream *Stream,
+                                             int AdditionalAmount, int TotalAmount)
+{
+    sdl_audio_thread *AudioThread = (sdl_audio_thread *)UserData;
+    if (AdditionalAmount > 0)
+    {
+        AtomicStoreRelease(&AudioThread->UnderrunCount, AudioThread->UnderrunCount + 1);
+    }
+}
+
+static int SDLAudioThreadProc(void *Data)
 {
-    if (AdditionalAmount > 0) {
-        uint8_t *Data = SDL_stack_alloc(uint8_t, AdditionalAmount);
-        if (Data) {
+    sdl_audio_thread *AudioThread = (sdl_audio_thread *)Data;
+    sdl_sound_output *SoundOutput = &AudioThread->SoundOutput;
 
-            sdl_audio_ring_buffer *RingBuffer = (sdl_audio_ring_buffer *)UserData;
+    if (!SDL_SetCurrentThreadPriority(SDL_THREAD_PRIORITY_TIME_CRITICAL))
+    {
+        SDL_Log("Couldn't raise audio thread priority: %s", SDL_GetError());
+    }
 
-            int Region1Size = AdditionalAmount;
-            int Region2Size = 0;
-            if (RingBuffer->PlayCursor + AdditionalAmount > RingBuffer->Size)
-            {
-                Region1Size = RingBuffer->Size - RingBuffer->PlayCursor;
-                Region2Size = AdditionalAmount - Region1Size;
-            }
-            memcpy(Data, (uint8_t*)(RingBuffer->Data) + RingBuffer->PlayCursor, Region1Size);
-            memcpy(&Data[Region1Size], RingBuffer->Data, Region2Size);
-            RingBuffer->PlayCursor = (RingBuffer->PlayCursor + AdditionalAmount) % RingBuffer->Size;
-            RingBuffer->WriteCursor = (RingBuffer->PlayCursor + AdditionalAmount) % RingBuffer->Size;
+    // NOTE: Wake up a few times per block so the queue never drains between checks.
+    uint64_t BlockNS = (1000000000ULL * SoundOutput->BlockSampleCount) / SoundOutput->SamplesPerSecond;
+    uint64_t SleepNS = BlockNS / 4;
 
-            SDL_PutAudioStreamData(Stream, Data, AdditionalAmount);
-            SDL_stack_free(Data);
+    bool Started = false;
+    while (!AtomicLoadAcquire(&AudioThread->Quit))
+    {
+        int QueuedSampleCount = SDL_GetAudioStreamQueued(AudioThread->Stream) / SoundOutput->BytesPerSample;
+
+        while (QueuedSampleCount < SoundOutput->LatencySampleCount)
+        {
+            game_sound_output_buffer SoundBuffer = {};
+            SoundBuffer.SamplesPerSecond = SoundOutput->SamplesPerSecond;
+            SoundBuffer.SampleCount = SoundOutput->BlockSampleCount;
+            SoundBuffer.Samples = AudioThread->Samples;
+
+            GameGetSoundSamples(AudioThread->Memory, &SoundBuffer);
+            SDL_PutAudioStreamData(AudioThread->Stream, AudioThread->Samples,
+                                   SoundBuffer.SampleCount * SoundOutput->BytesPerSample);
+
+            QueuedSampleCount += SoundBuffer.SampleCount;
+            AtomicStoreRelease(&AudioThread->RunningSampleIndex,
+                               AudioThread->RunningSampleIndex + SoundBuffer.SampleCount);
         }
+        AtomicStoreRelease(&AudioThread->QueuedSampleCount, QueuedSampleCount);
+
+        // NOTE: Only start the device once the first blocks are queued, so startup isn't counted as an underrun.
+        if (!Started)
+        {
+            SDL_ResumeAudioStreamDevice(AudioThread->Stream);
+            Started = true;
+        }
+
+        SDL_DelayNS(SleepNS);
     }
+
+    return 0;
 }
 
-static bool SDLInitAudio(int32_t SamplesPerSecond, int32_t BufferSize) {
+// NOTE: Game memory must be set up before this, the mixer lives in it.
+static bool SDLStartAudioThread(sdl_audio_thread *AudioThread, sdl_sound_output *SoundOutput, game_memory *Memory) {
     SDL_AudioSpec AudioSettings;
 
-    AudioSettings.freq = SamplesPerSecond;
+    AudioSettings.freq = SoundOutput->SamplesPerSecond;
     AudioSettings.format = SDL_AUDIO_S16LE;
     AudioSettings.channels = 2;
 
-    AudioRingBuffer.Size = BufferSize;
-    AudioRingBuffer.Data = calloc(BufferSize, 1);
-    AudioRingBuffer.PlayCursor = AudioRingBuffer.WriteCursor = 0;
+    AudioThread->SoundOutput = *SoundOutput;
+    AudioThread->Memory = Memory;
+    AudioThread->Samples = (int16_t *)calloc(SoundOutput->BlockSampleCount, SoundOutput->BytesPerSample);
 
-    GlobalStream = SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &AudioSettings, &SDLAudioCallback, &AudioRingBuffer);
-    if (!GlobalStream) {
+    // NOTE: No data callback; the audio thread pushes data into the stream itself.
+    // The get callback only watches for underruns.
+    AudioThread->Stream = SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &AudioSettings, NULL, NULL);
+    if (!AudioThread->Stream) {
         SDL_Log("Couldn't create audio stream: %s", SDL_GetError());
         return false;
     }
+    SDL_SetAudioStreamGetCallback(AudioThread->Stream, SDLAudioStreamGetCallback, AudioThread);
+
+    AudioThread->Thread = SDL_CreateThread(SDLAudioThreadProc, "EverydayAudio", AudioThread);
+    if (!AudioThread->Thread) {
+        SDL_Log("Couldn't create audio thread: %s", SDL_GetError());
+        return false;
+    }
+
+    return true;
+}
+
+static void SDLStopAudioThread(sdl_audio_thread *AudioThread)
+{
+    AtomicStoreRelease(&AudioThread->Quit, true);
+    SDL_WaitThread(AudioThread->Thread, NULL);
+    SDL_DestroyAudioStream(AudioThread->Stream);
+    free(AudioThread->Samples);
+}
+
+static int SDLGameThreadProc(void *Data)
+{
+    sdl_game_thread *GameThread = (sdl_game_thread *)Data;
+
+    for(;;)
+    {
+        SDL_WaitSemaphore(GameThread->WorkReady);
+        if (GameThread->Quit)
+        {
+            break;
+        }
+
+        uint64_t StartCounter = SDL_GetPerformanceCounter();
+        GameUpdateAndRender(GameThread->Memory, GameThread->Input, GameThread->Buffer);
+        GameThread->GameCounterElapsed = SDL_GetPerformanceCounter() - StartCounter;
+
+        SDL_SignalSemaphore(GameThread->WorkDone);
+    }
+
+    return 0;
+}
+
+static bool SDLStartGameThread(sdl_game_thread *GameThread, game_memory *Memory)
+{
+    GameThread->Memory = Memory;
+    GameThread->WorkReady = SDL_CreateSemaphore(0);
+    GameThread->WorkDone = SDL_CreateSemaphore(0);
+    if (!GameThread->WorkReady || !GameThread->WorkDone)
+    {
+        SDL_Log("Couldn't create game thread semaphores: %s", SDL_GetError());
+        return false;
+    }
+
+    GameThread->Thread = SDL_CreateThread(SDLGameThreadProc, "EverydayGame", GameThread);
+    if (!GameThread->Thread)
+    {
+        SDL_Log("Couldn't create game thread: %s", SDL_GetError());
+        return false;
+    }
 
     return true;
 }
 
+static void SDLStopGameThread(sdl_game_thread *GameThread)
+{
+    GameThread->Quit = true;
+    SDL_SignalSemaphore(GameThread->WorkReady);
+    SDL_WaitThread(GameThread->Thread, NULL);
+    SDL_DestroySemaphore(GameThread->WorkReady);
+    SDL_DestroySemaphore(GameThread->WorkDone);
+}
+
+// NOTE: Only call when a frame is pending on the game thread: it blocks until that
+// frame is done, and the game thread is idle again once it returns.
+static void SDLFinishGameFrame(sdl_game_thread *GameThread)
+{
+    uint64_t StartCounter = SDL_GetPerformanceCounter();
+    SDL_WaitSemaphore(GameThread->WorkDone);
+    GlobalDebugStats.TimerElapsed[DebugTimer_WaitForGame] = SDL_GetPerformanceCounter() - StartCounter;
+    GlobalDebugStats.TimerElapsed[DebugTimer_Game] = GameThread->GameCounterElapsed;
+
+    ++GlobalFrameIndex;
+#if EVERYDAY_INTERNAL
+    // NOTE: Per-frame game state hash, for spotting desyncs between runs.
+    if (GlobalSnapshots.Storage) {
+        GlobalStateHash = HashGameState(&GlobalSnapshots);
+    }
+#endif
+}
+
+static float SDLCounterToMS(uint64_t Counter)
+{
+    return((1000.0f * (float)Counter) / (float)SDL_GetPerformanceFrequency());
+}
+
+static void SDLDrawDebugOverlay(game_offscreen_buffer *Buffer)
+{
+    int Scale = 2;
+    uint32_t TextColor = 0x00FFFF80;
+    char Text[1024];
+    int TextSize = 0;
+
+    TextSize += snprintf(Text + TextSize, sizeof(Text) - TextSize, "%6.2f ms/f %6.1f f/s %s\n",
+                         GlobalDebugStats.MSPerFrame, GlobalDebugStats.FPS, GlobalPipelined ? "pipelined" : "serial");
+    TextSize += snprintf(Text + TextSize, sizeof(Text) - TextSize, "Audio %10u queued %5u underruns %u\n",
+                         AtomicLoadAcquire(&GlobalAudioThread.RunningSampleIndex),
+                         AtomicLoadAcquire(&GlobalAudioThread.QueuedSampleCount),
+                         AtomicLoadAcquire(&GlobalAudioThread.UnderrunCount));
+
+    if (GlobalSnapshots.Storage) {
+        uint64_t ResidentPages = SnapshotQueryResidency(&GlobalSnapshots, GlobalSnapshots.Residency);
+        TextSize += snprintf(Text + TextSize, sizeof(Text) - TextSize, "Arena %llu/%llu KB slot %d\n",
+                             (unsigned long long)(ResidentPages * GlobalSnapshots.PageSize / 1024),
+                             (unsigned long long)(GlobalSnapshots.StorageSize / 1024),
+                             GlobalSnapshots.ActiveSlot);
+    }
+#if EVERYDAY_INTERNAL
+    TextSize += snprintf(Text + TextSize, sizeof(Text) - TextSize, "State %016llx\n",
+                         (unsigned long long)GlobalStateHash);
+#endif
+
+    // NOTE: Top timers of the last frame, slowest first.
+    int Order[DebugTimer_Count];
+    for (int TimerIndex = 0; TimerIndex < DebugTimer_Count; ++TimerIndex) {
+        int InsertAt = TimerIndex;
+        while (InsertAt > 0 &&
+               GlobalDebugStats.TimerElapsed[Order[InsertAt - 1]] < GlobalDebugStats.TimerElapsed[TimerIndex]) {
+            Order[InsertAt] = Order[InsertAt - 1];
+            --InsertAt;
+        }
+        Order[InsertAt] = TimerIndex;
+    }
+    for (int Rank = 0; Rank < 4; ++Rank) {
+        TextSize += snprintf(Text + TextSize, sizeof(Text) - TextSize, "%-13s %7.3f ms\n",
+                             DebugTimerNames[Order[Rank]],
+                             SDLCounterToMS(GlobalDebugStats.TimerElapsed[Order[Rank]]));
+    }
+
+    int LineCount = 0;
+    int LineLength = 0;
+    int MaxLineLength = 0;
+    for (char *At = Text; *At; ++At) {
+        if (*At == '\n') {
+            ++LineCount;
+            LineLength = 0;
+        } else if (++LineLength > MaxLineLength) {
+            MaxLineLength = LineLength;
+        }
+    }
+
+    int X = 8;
+    int Y = 8;
+    DarkenRectangle(Buffer, X - Scale, Y - Scale,
+                    X + MaxLineLength * GetTextAdvanceX(Scale) + Scale,
+                    Y + LineCount * GetTextAdvanceY(Scale) + Scale);
+    DrawDebugText(Buffer, X, Y, Scale, TextColor, Text);
+}
+
+// NOTE: Draws the overlay on top of a finished frame and puts it on screen.
+static void SDLPresentFrame(SDL_Renderer *Renderer, game_offscreen_buffer *Buffer)
+{
+    uint64_t StartCounter = SDL_GetPerformanceCounter();
+    if (GlobalShowDebugOverlay) {
+        SDLDrawDebugOverlay(Buffer);
+    }
+    uint64_t OverlayCounter = SDL_GetPerformanceCounter();
+    GlobalDebugStats.TimerElapsed[DebugTimer_Overlay] = OverlayCounter - StartCounter;
+
+    DisplayBufferInWindow(Renderer, Buffer);
+    GlobalDebugStats.TimerElapsed[DebugTimer_Present] = SDL_GetPerformanceCounter() - OverlayCounter;
+}
+
+// NOTE: Average frame time since the last call, to compare pipelined and serial runs.
+static void SDLLogFrameRate()
+{
+    if (GlobalDebugStats.ModeFrameCount) {
+        float MSPerFrame = SDLCounterToMS(GlobalDebugStats.ModeCounterElapsed) / (float)GlobalDebugStats.ModeFrameCount;
+        SDL_Log("%s: %u frames, %.02f ms/f, %.02f f/s", GlobalPipelined ? "Pipelined" : "Serial",
+                GlobalDebugStats.ModeFrameCount, MSPerFrame, 1000.0f / MSPerFrame);
+    }
+    GlobalDebugStats.ModeCounterElapsed = 0;
+    GlobalDebugStats.ModeFrameCount = 0;
+}
+
+static void SDLQuickSave()
+{
+    // NOTE: Nothing worth saving until the game has initialized its state.
+    if (!GlobalSnapshots.Storage || GlobalFrameIndex == 0) {
+        return;
+    }
+
+    uint64_t StartCounter = SDL_GetPerformanceCounter();
+    SnapshotSave(&GlobalSnapshots, GlobalSnapshots.ActiveSlot);
+    uint64_t EndCounter = SDL_GetPerformanceCounter();
+
+    state_snapshot_slot *Slot = &GlobalSnapshots.Slots[GlobalSnapshots.ActiveSlot];
+    SDL_Log("Saved slot %d: %llu pages, %.03f ms, hash %016llx", GlobalSnapshots.ActiveSlot,
+            (unsigned long long)Slot->PagesCopied,
+            (1000.0f * (float)(EndCounter - StartCounter)) / (float)SDL_GetPerformanceFrequency(),
+            (unsigned long long)Slot->StateHash);
+}
+
+static void SDLQuickLoad()
+{
+    if (!GlobalSnapshots.Storage) {
+        return;
+    }
+
+    state_snapshot_slot *Slot = &GlobalSnapshots.Slots[GlobalSnapshots.ActiveSlot];
+    if (!Slot->IsValid) {
+        SDL_Log("Slot %d is empty", GlobalSnapshots.ActiveSlot);
+        return;
+    }
+
+    uint64_t StartCounter = SDL_GetPerformanceCounter();
+    bool HashMatches = SnapshotLoad(&GlobalSnapshots, GlobalSnapshots.ActiveSlot);
+    uint64_t EndCounter = SDL_GetPerformanceCounter();
+
+    SDL_Log("Loaded slot %d: %.03f ms%s", GlobalSnapshots.ActiveSlot,
+            (1000.0f * (float)(EndCounter - StartCounter)) / (float)SDL_GetPerformanceFrequency(),
+            HashMatches ? "" : ", STATE HASH MISMATCH");
+}
+
 bool HandleEvent(SDL_Event *event) {
     bool should_quit = false;
 
@@ -254,9 +525,12 @@ bool HandleEvent(SDL_Event *event) {
         case SDL_EVENT_WINDOW_EXPOSED:
             {
                 SDL_Log("SDL_EVENT_WINDOW_EXPOSED");
-                SDL_Window *Window = SDL_GetWindowFromID(event->window.windowID);
-                SDL_Renderer *Renderer = SDL_GetRenderer(Window);
-                DisplayBufferInWindow(Renderer);
+                // NOTE: Freshly resized buffers are blank; the next frame is presented right away instead.
+                if (!GlobalBackBuffersResized) {
+                    SDL_Window *Window = SDL_GetWindowFromID(event->window.windowID);
+                    SDL_Renderer *Renderer = SDL_GetRenderer(Window);
+                    DisplayBufferInWindow(Renderer, &GlobalBackBuffers[GlobalPresentBufferIndex]);
+                }
             } break;
         case SDL_EVENT_KEY_UP:
         case SDL_EVENT_KEY_DOWN:
@@ -265,6 +539,21 @@ bool HandleEvent(SDL_Event *event) {
                 if (event->key.key == SDLK_ESCAPE) {
                     should_quit = true;
                 }
+                if (event->key.down && !event->key.repeat) {
+                    if (event->key.key == SDLK_F5) {
+                        SDLQuickSave();
+                    } else if (event->key.key == SDLK_F9) {
+                        SDLQuickLoad();
+                    } else if (event->key.key == SDLK_F1) {
+                        GlobalShowDebugOverlay = !GlobalShowDebugOverlay;
+                    } else if (event->key.key == SDLK_F2) {
+                        SDLLogFrameRate();
+                        GlobalPipelined = !GlobalPipelined;
+                    } else if (event->key.key == SDLK_F6) {
+                        GlobalSnapshots.ActiveSlot = (GlobalSnapshots.ActiveSlot + 1) % SNAPSHOT_SLOT_COUNT;
+                        SDL_Log("Active save slot %d", GlobalSnapshots.ActiveSlot);
+                    }
+                }
             } break;
         case SDL_EVENT_JOYSTICK_ADDED:
             {
@@ -332,7 +621,13 @@ SDLCloseGameControllers()
     }
 }
 
-int main() {
+int main(int ArgCount, char **Args) {
+    for (int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex) {
+        if (strcmp(Args[ArgIndex], "--serial") == 0) {
+            GlobalPipelined = false;
+        }
+    }
+
     if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_JOYSTICK | SDL_INIT_AUDIO)) {
         SDL_Log("SDL_Init failed: %s", SDL_GetError());
         return 1;
@@ -355,17 +650,9 @@ int main() {
         // NOTE: Sound test
         sdl_sound_output SoundOutput = {};
         SoundOutput.SamplesPerSecond = 48000;
-        SoundOutput.RunningSampleIndex = 0;
         SoundOutput.BytesPerSample = sizeof(int16_t) * 2;
-        SoundOutput.SecondaryBufferSize = SoundOutput.SamplesPerSecond * SoundOutput.BytesPerSample;
-        SoundOutput.LatencySampleCount = SoundOutput.SamplesPerSecond / 15;
-        // Open our audio device:
-        if(!SDLInitAudio(SoundOutput.SamplesPerSecond, SoundOutput.SecondaryBufferSize)) {
-            SDL_Log("Audio initialization failed");
-            return 1;
-        }
-        int16_t *Samples = (int16_t *)calloc(SoundOutput.SamplesPerSecond, SoundOutput.BytesPerSample);
-
+        SoundOutput.BlockSampleCount = 256;
+        SoundOutput.LatencySampleCount = 4 * SoundOutput.BlockSampleCount;
 
 #if EVERYDAY_INTERNAL
         // TODO: This will fail gently on 32-bit at the moment, but we should probably fix it.
@@ -389,15 +676,41 @@ int main() {
 
         GameMemory.TransientStorage = (uint8_t*)(GameMemory.PersistentStorage) + GameMemory.PersistentStorageSize;
 
+        if (!SnapshotInit(&GlobalSnapshots, GameMemory.PersistentStorage, GameMemory.PersistentStorageSize, EVERYDAY_INTERNAL)) {
+            SDL_Log("Save state slots unavailable");
+            GlobalSnapshots.Storage = 0;
+        }
+
 
 
-        bool SoundEnabled = false;
+        // Open our audio device:
+        if(!SDLStartAudioThread(&GlobalAudioThread, &SoundOutput, &GameMemory)) {
+            SDL_Log("Audio initialization failed");
+            return 1;
+        }
+
+        sdl_game_thread GameThread = {};
+        if (!SDLStartGameThread(&GameThread, &GameMemory)) {
+            return 1;
+        }
+
+        int SimBufferIndex = 0;
+        bool FramePending = false;
+        bool FrameReady = false;
 
         bool Running = true;
 
         while (Running) {
             uint64_t LastCounter = SDL_GetPerformanceCounter();
 
+            // NOTE: Collect the frame the game thread was working on. From here until the
+            // next kick the game thread is idle, so events, input and resizes are safe.
+            if (FramePending) {
+                SDLFinishGameFrame(&GameThread);
+                FramePending = false;
+            }
+
+            uint64_t EventsCounter = SDL_GetPerformanceCounter();
             SDL_Event event;
 
             while(SDL_PollEvent(&event)) {
@@ -407,6 +720,9 @@ int main() {
                 }
             }
 
+            uint64_t InputCounter = SDL_GetPerformanceCounter();
+            GlobalDebugStats.TimerElapsed[DebugTimer_Events] = InputCounter - EventsCounter;
+
             // Poll our controllers for input.
             for (int ControllerIndex = 0; ControllerIndex < MAX_CONTROLLERS; ++ControllerIndex)
             {
@@ -486,48 +802,39 @@ int main() {
                 }
             }
 
-            // Sound output test
-            int ByteToLock = (SoundOutput.RunningSampleIndex*SoundOutput.BytesPerSample) % SoundOutput.SecondaryBufferSize;
-            int TargetCursor = ((AudioRingBuffer.PlayCursor +
-                                 (SoundOutput.LatencySampleCount*SoundOutput.BytesPerSample)) %
-                                SoundOutput.SecondaryBufferSize);
-            int BytesToWrite;
-            if(ByteToLock > TargetCursor)
-            {
-                BytesToWrite = (SoundOutput.SecondaryBufferSize - ByteToLock);
-                BytesToWrite += TargetCursor;
-            }
-            else
-            {
-                BytesToWrite = TargetCursor - ByteToLock;
-            }
-
-            game_sound_output_buffer SoundBuffer = {};
-            SoundBuffer.SamplesPerSecond = SoundOutput.SamplesPerSecond;
-            SoundBuffer.SampleCount = BytesToWrite / SoundOutput.BytesPerSample;
-            SoundBuffer.Samples = Samples;
+            GlobalDebugStats.TimerElapsed[DebugTimer_Input] = SDL_GetPerformanceCounter() - InputCounter;
 
-            game_offscreen_buffer Buffer = {};
-            Buffer.Memory = GlobalBackBuffer.Memory;
-            Buffer.Width = GlobalBackBuffer.Width; 
-            Buffer.Height = GlobalBackBuffer.Height;
-            Buffer.Pitch = GlobalBackBuffer.Pitch; 
+            GameThread.Input = NewInput;
+            GameThread.Buffer = &GlobalBackBuffers[SimBufferIndex];
 
-            GameUpdateAndRender(&GameMemory, NewInput, &Buffer, &SoundBuffer);
+            SDL_SignalSemaphore(GameThread.WorkReady);
+            FramePending = true;
 
             game_input *Temp = NewInput;
             NewInput = OldInput;
             OldInput = Temp;
 
-            SDLFillSoundBuffer(&SoundOutput, ByteToLock, BytesToWrite, &SoundBuffer); 
-
-            if (!SoundEnabled) {
-                SDL_ResumeAudioStreamDevice(GlobalStream);
-                SoundEnabled = true;
+            if (GlobalPipelined && !GlobalBackBuffersResized) {
+                // NOTE: Present the previous frame while the game thread builds this one.
+                if (FrameReady) {
+                    SDLPresentFrame(Renderer, &GlobalBackBuffers[GlobalPresentBufferIndex]);
+                }
+                GlobalPresentBufferIndex = SimBufferIndex;
+                SimBufferIndex = !SimBufferIndex;
+                FrameReady = true;
+            } else {
+                // NOTE: Also taken right after a resize, when the previous frame was
+                // thrown away with the old buffers: wait for this frame rather than
+                // presenting a blank one.
+                SDLFinishGameFrame(&GameThread);
+                FramePending = false;
+
+                GlobalPresentBufferIndex = SimBufferIndex;
+                SDLPresentFrame(Renderer, &GlobalBackBuffers[GlobalPresentBufferIndex]);
+                FrameReady = false;
+                GlobalBackBuffersResized = false;
             }
 
-            DisplayBufferInWindow(Renderer);
-
             uint64_t PerfCountFrequency = SDL_GetPerformanceFrequency();
             uint64_t EndCounter = SDL_GetPerformanceCounter();
             uint64_t CounterElapsed = EndCounter - LastCounter;
@@ -535,10 +842,22 @@ int main() {
             float MSPerFrame = (((1000.0f * (float)CounterElapsed) / (float)PerfCountFrequency));
             float FPS = (float)PerfCountFrequency / (float)CounterElapsed;
 
+            GlobalDebugStats.MSPerFrame = MSPerFrame;
+            GlobalDebugStats.FPS = FPS;
+            GlobalDebugStats.ModeCounterElapsed += CounterElapsed;
+            ++GlobalDebugStats.ModeFrameCount;
+
             //SDL_Log("%.02f ms/f, %.02ff/s\n", MSPerFrame, FPS);
             LastCounter = EndCounter;
         }
 
+        if (FramePending) {
+            SDL_WaitSemaphore(GameThread.WorkDone);
+        }
+        SDLLogFrameRate();
+        SDLStopGameThread(&GameThread);
+        SDLStopAudioThread(&GlobalAudioThread);
+
         SDL_DestroyRenderer(Renderer);
         SDL_DestroyWindow(Window);
 
@@ -18,22 +18,71 @@ struct sdl_window_dimension
     int Height;
 };
 
-struct sdl_audio_ring_buffer
-{
-    int Size;
-    int WriteCursor;
-    int PlayCursor;
-    void *Data;
-};
-
 struct sdl_sound_output
 {
     int SamplesPerSecond;
-    uint32_t RunningSampleIndex;
     int BytesPerSample;
-    int SecondaryBufferSize;
+    int BlockSampleCount;
     int LatencySampleCount;
 };
 
+// NOTE: The audio thread mixes BlockSampleCount samples at a time, straight into
+// the audio stream, whenever less than LatencySampleCount samples are queued.
+// It never waits on the game thread, so long video frames don't starve it.
+struct sdl_audio_thread
+{
+    SDL_Thread *Thread;
+    SDL_AudioStream *Stream;
+    game_memory *Memory;
+    sdl_sound_output SoundOutput;
+    int16_t *Samples;
+    volatile uint32_t Quit;
+
+    // NOTE: Written by the audio thread, read by the debug overlay.
+    volatile uint32_t RunningSampleIndex;
+    volatile uint32_t QueuedSampleCount;
+    volatile uint32_t UnderrunCount;
+};
+
+// NOTE: One unit of work for the game thread. The main thread fills this in,
+// signals WorkReady and is free to present the previous frame until it waits
+// on WorkDone.
+struct sdl_game_thread
+{
+    SDL_Thread *Thread;
+    SDL_Semaphore *WorkReady;
+    SDL_Semaphore *WorkDone;
+    bool32 Quit;
+
+    game_memory *Memory;
+    game_input *Input;
+    game_offscreen_buffer *Buffer;
+    uint64_t GameCounterElapsed;
+};
+
+enum
+{
+    DebugTimer_Game,
+    DebugTimer_WaitForGame,
+    DebugTimer_Events,
+    DebugTimer_Input,
+    DebugTimer_Present,
+    DebugTimer_Overlay,
+
+    DebugTimer_Count,
+};
+
+// NOTE: Timings from the last completed frame, in performance counter ticks.
+struct sdl_debug_stats
+{
+    float MSPerFrame;
+    float FPS;
+    uint64_t TimerElapsed[DebugTimer_Count];
+
+    // NOTE: Accumulated since the pipelining mode last changed.
+    uint64_t ModeCounterElapsed;
+    uint32_t ModeFrameCount;
+};
+
 #define SDL_EVERYDAY_H
 #endif
\ No newline at end of file